@@ -4,14 +4,28 @@ if(NOT GlslangValidator)
    message(FATAL_ERROR "failed to find glslangValidator")
 endif()
 
+# Compile GLSL compute shader to SPIR-V.
+# Optional TARGET_ENV (like vulkan1.1) is needed for shaders using features beyond Vulkan 1.0,
+# e.g. subgroup operations.
+# With optional VARIABLE the TARGET is a C++ header defining the array of SPIR-V words
+# with a given name (const uint32_t VARIABLE[]), which can be passed to vuh::Program directly.
 function(vuh_compile_shader)
-   set(OneValueArgs SOURCE TARGET)
+   set(OneValueArgs SOURCE TARGET TARGET_ENV VARIABLE)
    cmake_parse_arguments(COMPILE_SHADER "" "${OneValueArgs}" "" ${ARGN})
 
+   set(TargetEnv "")
+   if(COMPILE_SHADER_TARGET_ENV)
+      set(TargetEnv --target-env ${COMPILE_SHADER_TARGET_ENV})
+   endif()
+   set(Variable "")
+   if(COMPILE_SHADER_VARIABLE)
+      set(Variable --vn ${COMPILE_SHADER_VARIABLE})
+   endif()
+
    get_filename_component(TargetDir ${COMPILE_SHADER_TARGET} DIRECTORY)
    add_custom_command(
       COMMAND ${CMAKE_COMMAND} ARGS -E make_directory ${TargetDir}
-      COMMAND ${GlslangValidator} ARGS -V ${COMPILE_SHADER_SOURCE} -o ${COMPILE_SHADER_TARGET}
+      COMMAND ${GlslangValidator} ARGS -V ${TargetEnv} ${Variable} ${COMPILE_SHADER_SOURCE} -o ${COMPILE_SHADER_TARGET}
       DEPENDS ${COMPILE_SHADER_SOURCE}
       OUTPUT ${COMPILE_SHADER_TARGET}
    )
@@ -1,17 +1,50 @@
 #include <vuh/device.h>
 #include <vuh/error.h>
+#include <vuh/instance.h>
 #include <vuh/internal/utils.h>
+#include <vuh/utils.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <initializer_list>
+#include <sstream>
 #include <limits>
+#include <thread>
 
 namespace {
 	/// Vendor-specific extensions which provide useful features
 	static const std::array<const char*, 1> vendor_device_extensions = {"VK_AMD_shader_core_properties"};
 
+	/// Extensions enabled when available as they are needed for some optional features
+	static const std::array<const char*, 5> optional_device_extensions = {
+		"VK_KHR_push_descriptor"
+	  , "VK_KHR_maintenance3"        // required by VK_EXT_descriptor_indexing
+	  , "VK_EXT_descriptor_indexing"
+	  , "VK_KHR_device_group"        // device address memory allocation flags, dispatch with base offsets
+	  , "VK_KHR_buffer_device_address"
+	};
+
+	/// Optional extensions depending on Vulkan 1.1, enabled when available on 1.1+ devices
+	static const std::array<const char*, 2> optional_device_extensions_1_1 = {
+		"VK_EXT_subgroup_size_control"
+	  , "VK_KHR_timeline_semaphore"
+	};
+
+	/// @return Vulkan API version usable with the physical device, that is the lower of
+	/// the one instance was created with and the one supported by the device
+	auto api_version(const vuh::Instance& instance, vk::PhysicalDevice physdev)-> uint32_t {
+		return std::min(instance.apiVersion(), physdev.getProperties().apiVersion);
+	}
+
 	/// Filter through the device's extensions
-	auto filter_extensions(vk::PhysicalDevice& physicalDevice, const std::vector<const char*>& extensions
+	auto filter_extensions(vk::PhysicalDevice& physicalDevice, uint32_t version
+	                       , const std::vector<const char*>& extensions
 						, bool add_available_vendor=true, bool all_required=true) {
 		const auto avail_extensions = physicalDevice.enumerateDeviceExtensionProperties();
 		auto r = filter_list({}, extensions, avail_extensions
@@ -23,13 +56,180 @@ namespace {
 		// Add vendor extensions if they exist
 		r = filter_list(std::move(r), vendor_device_extensions, avail_extensions
 		                , [](const auto& l){return l.extensionName;});
-			
+
+		// Add optional extensions (unless explicitly requested already)
+		for(auto e: optional_device_extensions){
+			if(!contains(e, r, [](const char* s){ return s; })
+			   && contains(e, avail_extensions, [](const auto& l){ return l.extensionName; }))
+			{
+				r.push_back(e);
+			}
+		}
+		if(version >= VK_API_VERSION_1_1){
+			for(auto e: optional_device_extensions_1_1){
+				if(!contains(e, r, [](const char* s){ return s; })
+				   && contains(e, avail_extensions, [](const auto& l){ return l.extensionName; }))
+				{
+					r.push_back(e);
+				}
+			}
+		}
+		return r;
+	}
+
+	/// Chain of structures describing the optional device features.
+	/// Only structures corresponding to the enabled extensions are linked to the chain.
+	/// Not copyable as the chain links the members through pointers.
+	struct FeatureChain {
+		vk::PhysicalDeviceFeatures2KHR features2;
+		vk::PhysicalDeviceDescriptorIndexingFeaturesEXT indexing;
+		vk::PhysicalDeviceBufferDeviceAddressFeaturesKHR address;
+		vk::PhysicalDeviceSubgroupSizeControlFeaturesEXT subgroup_size;
+		vk::PhysicalDeviceTimelineSemaphoreFeaturesKHR timeline;
+
+		explicit FeatureChain(const std::vector<const char*>& extensions){
+			auto next = &features2.pNext;
+			auto link = [&](const char* ext, auto& s){
+				if(contains(ext, extensions, [](const char* e){ return e; })){
+					*next = &s;
+					next = &s.pNext;
+				}
+			};
+			link("VK_EXT_descriptor_indexing", indexing);
+			if(contains("VK_KHR_device_group", extensions, [](const char* e){ return e; })){
+				link("VK_KHR_buffer_device_address", address);
+			}
+			link("VK_EXT_subgroup_size_control", subgroup_size);
+			link("VK_KHR_timeline_semaphore", timeline);
+		}
+		FeatureChain(const FeatureChain&) = delete;
+		auto operator=(const FeatureChain&)-> FeatureChain& = delete;
+	};
+
+	/// @return vkGetPhysicalDeviceProperties2 (core in Vulkan 1.1) or its
+	/// VK_KHR_get_physical_device_properties2 counterpart, nullptr if neither is available
+	auto properties2_fn(const vuh::Instance& instance)-> PFN_vkGetPhysicalDeviceProperties2KHR {
+		if(instance.apiVersion() >= VK_API_VERSION_1_1){
+			auto fn = instance.getProcAddr("vkGetPhysicalDeviceProperties2");
+			if(fn){
+				return PFN_vkGetPhysicalDeviceProperties2KHR(fn);
+			}
+		}
+		return instance.hasExtension("VK_KHR_get_physical_device_properties2")
+		       ? PFN_vkGetPhysicalDeviceProperties2KHR(
+		                            instance.getProcAddr("vkGetPhysicalDeviceProperties2KHR"))
+		       : nullptr;
+	}
+
+	/// @return vkGetPhysicalDeviceFeatures2 (core in Vulkan 1.1) or its
+	/// VK_KHR_get_physical_device_properties2 counterpart, nullptr if neither is available
+	auto features2_fn(const vuh::Instance& instance)-> PFN_vkGetPhysicalDeviceFeatures2KHR {
+		if(instance.apiVersion() >= VK_API_VERSION_1_1){
+			auto fn = instance.getProcAddr("vkGetPhysicalDeviceFeatures2");
+			if(fn){
+				return PFN_vkGetPhysicalDeviceFeatures2KHR(fn);
+			}
+		}
+		return instance.hasExtension("VK_KHR_get_physical_device_properties2")
+		       ? PFN_vkGetPhysicalDeviceFeatures2KHR(
+		                            instance.getProcAddr("vkGetPhysicalDeviceFeatures2KHR"))
+		       : nullptr;
+	}
+
+	/// Query the optional features supported by the physical device.
+	/// Querying requires Vulkan 1.1 or VK_KHR_get_physical_device_properties2 instance extension.
+	/// @return false if features could not be queried (chain is left zero-initialized then)
+	auto query_features(const vuh::Instance& instance, vk::PhysicalDevice physdev
+	                    , FeatureChain& chain
+	                    )-> bool
+	{
+		auto fn = features2_fn(instance);
+		if(!fn){
+			return false;
+		}
+		fn(physdev, reinterpret_cast<VkPhysicalDeviceFeatures2KHR*>(&chain.features2));
+		return true;
+	}
+
+	/// Fill in the subgroup properties of the physical device.
+	/// Subgroup properties are core in Vulkan 1.1, so are left at defaults for 1.0 devices.
+	/// Subgroup size control is reported only if the feature is supported and compute kernels
+	/// may require the subgroup size.
+	auto query_subgroup(const vuh::Instance& instance, vk::PhysicalDevice physdev
+	                    , const std::vector<const char*>& extensions
+	                    , const FeatureChain& chain
+	                    , vuh::DeviceFeatures& r
+	                    )-> void
+	{
+		auto fn = properties2_fn(instance);
+		if(!fn || api_version(instance, physdev) < VK_API_VERSION_1_1){
+			return;
+		}
+		auto size_props = vk::PhysicalDeviceSubgroupSizeControlPropertiesEXT{};
+		auto subgroup_props = vk::PhysicalDeviceSubgroupProperties{};
+		auto props2 = vk::PhysicalDeviceProperties2KHR{};
+		props2.pNext = &subgroup_props;
+		const auto size_control = contains("VK_EXT_subgroup_size_control", extensions
+		                                   , [](const char* e){ return e; });
+		if(size_control){
+			subgroup_props.pNext = &size_props;
+		}
+		fn(physdev, reinterpret_cast<VkPhysicalDeviceProperties2KHR*>(&props2));
+		r.subgroup_size = std::max(1u, subgroup_props.subgroupSize);
+		if(subgroup_props.supportedStages & vk::ShaderStageFlagBits::eCompute){
+			r.subgroup_operations = subgroup_props.supportedOperations;
+		}
+		r.subgroup_size_control = size_control && chain.subgroup_size.subgroupSizeControl
+		                  && (size_props.requiredSubgroupSizeStages & vk::ShaderStageFlagBits::eCompute);
+		if(r.subgroup_size_control){
+			r.min_subgroup_size = size_props.minSubgroupSize;
+			r.max_subgroup_size = size_props.maxSubgroupSize;
+			r.max_workgroup_subgroups = size_props.maxComputeWorkgroupSubgroups;
+		}
+	}
+
+	/// @return summary of the optional features supported by the physical device
+	/// with a given set of extensions enabled.
+	auto device_features(const vuh::Instance& instance, vk::PhysicalDevice physdev
+	                     , const std::vector<const char*>& extensions
+	                     )-> vuh::DeviceFeatures
+	{
+		auto r = vuh::DeviceFeatures{};
+		FeatureChain chain(extensions);
+		const auto has_features = query_features(instance, physdev, chain);
+		query_subgroup(instance, physdev, extensions, chain, r);
+		if(!has_features){
+			return r;
+		}
+		const auto& idx = chain.indexing; // structures not linked to the chain stay zeroed
+		r.descriptor_indexing = idx.runtimeDescriptorArray
+		                        && idx.descriptorBindingStorageBufferUpdateAfterBind
+		                        && idx.descriptorBindingPartiallyBound
+		                        && idx.descriptorBindingVariableDescriptorCount
+		                        && idx.descriptorBindingUpdateUnusedWhilePending;
+		if(r.descriptor_indexing){
+			auto fn = properties2_fn(instance);
+			auto idx_props = vk::PhysicalDeviceDescriptorIndexingPropertiesEXT{};
+			auto props2 = vk::PhysicalDeviceProperties2KHR{};
+			props2.pNext = &idx_props;
+			if(fn){
+				fn(physdev, reinterpret_cast<VkPhysicalDeviceProperties2KHR*>(&props2));
+			}
+			r.max_update_after_bind_buffers = std::min(
+			                               idx_props.maxPerStageDescriptorUpdateAfterBindStorageBuffers
+			                             , idx_props.maxDescriptorSetUpdateAfterBindStorageBuffers);
+			r.descriptor_indexing = r.max_update_after_bind_buffers > 0;
+		}
+		r.buffer_device_address = chain.address.bufferDeviceAddress;
+		r.timeline_semaphore = chain.timeline.timelineSemaphore;
 		return r;
 	}
 
 	/// Create logical device.
 	/// Compute and transport queue family id may point to the same queue.
-	auto createDevice(const vk::PhysicalDevice& physicalDevice ///< physical device to wrap
+	/// All optional features (see FeatureChain) supported by the physical device are enabled.
+	auto createDevice(const vuh::Instance& instance              ///< instance physical device belongs to
+	                  , const vk::PhysicalDevice& physicalDevice ///< physical device to wrap
 	                  , uint32_t compute_family_id             ///< index of queue family supporting compute operations
 	                  , uint32_t transfer_family_id            ///< index of queue family supporting transfer operations
 					  , const std::vector<const char*>& extensions ///< list of device extensions
@@ -49,6 +249,13 @@ namespace {
 		auto devCI = vk::DeviceCreateInfo(vk::DeviceCreateFlags(), n_queues, queueCIs.data(),
 						0, nullptr, extensions.size(), extensions.data());
 
+		FeatureChain features(extensions);
+		if(query_features(instance, physicalDevice, features)){
+			features.features2.features = vk::PhysicalDeviceFeatures{}; // core features are not used
+			features.address.bufferDeviceAddressCaptureReplay = false;
+			features.address.bufferDeviceAddressMultiDevice = false;
+			devCI.pNext = &features.features2;
+		}
 		return physicalDevice.createDevice(devCI, nullptr);
 	}
 
@@ -77,6 +284,23 @@ namespace {
 		return r;
 	}
 
+	/// @return id of the first memory type matching the requirements and desired properties,
+	/// -1 if none found.
+	auto select_memory(const vk::PhysicalDeviceMemoryProperties& memProperties
+	                   , const vk::MemoryRequirements& memoryReqs
+	                   , vk::MemoryPropertyFlags properties
+	                   )-> uint32_t
+	{
+		for(uint32_t i = 0; i < memProperties.memoryTypeCount; ++i){
+			if( (memoryReqs.memoryTypeBits & (1u << i))
+			    && ((properties & memProperties.memoryTypes[i].propertyFlags) == properties))
+			{
+				return i;
+			}
+		}
+		return uint32_t(-1);
+	}
+
 	/// Allocate command buffer
 	auto allocCmdBuffer(vk::Device device
 	                    , vk::CommandPool pool
@@ -86,6 +310,232 @@ namespace {
 		auto commandBufferAI = vk::CommandBufferAllocateInfo(pool, level, 1); // 1 is the command buffer count here
 		return device.allocateCommandBuffers(commandBufferAI)[0];
 	}
+
+	/// Create timeline semaphore with the initial value 0.
+	auto createTimeline(vk::Device device)-> vk::Semaphore {
+		auto type_info = vk::SemaphoreTypeCreateInfoKHR(vk::SemaphoreType::eTimeline, 0);
+		auto semaphore_info = vk::SemaphoreCreateInfo();
+		semaphore_info.pNext = &type_info;
+		return device.createSemaphore(semaphore_info);
+	}
+
+	/// Timeline waits of the submission.
+	/// Dependencies on the same timeline fold to the one with the greatest value, so that there
+	/// is at most one wait per queue of the device.
+	struct TimelineWaits {
+		std::array<vk::Semaphore, 2> semaphores;
+		std::array<uint64_t, 2> values;
+		std::array<vk::PipelineStageFlags, 2> stages;
+		uint32_t count = 0;
+
+		TimelineWaits(const vuh::TimelinePoint* points, uint32_t n_points){
+			for(uint32_t i = 0; i < n_points; ++i){
+				const auto& p = points[i];
+				auto j = uint32_t(0);
+				while(j < count && semaphores[j] != p.semaphore){
+					++j;
+				}
+				if(j == count){
+					assert(count < semaphores.size()); // points should belong to the timelines of the same device
+					semaphores[j] = p.semaphore;
+					values[j] = 0;
+					stages[j] = vk::PipelineStageFlagBits::eAllCommands;
+					++count;
+				}
+				values[j] = std::max(values[j], p.value);
+			}
+		}
+	};
+
+	/// Header prepended to the pipeline cache data persisted on disk.
+	/// Identifies the device and driver the data was produced by and guards against
+	/// truncated or otherwise corrupted files.
+	struct PipelineCacheHeader {
+		uint32_t magic;               ///< identifies the vuh pipeline cache file
+		uint32_t version;             ///< file format version
+		uint32_t vendor_id;           ///< vendor id of the physical device
+		uint32_t device_id;           ///< device id of the physical device
+		uint32_t driver_version;      ///< driver version
+		uint8_t  uuid[VK_UUID_SIZE];  ///< pipeline cache UUID of the physical device
+		uint64_t data_size;           ///< size of the cache data following the header (bytes)
+		uint64_t checksum;            ///< hash of the cache data
+	};
+	static constexpr uint32_t pipecache_magic = 0x50485556u; // "VUHP"
+	static constexpr uint32_t pipecache_version = 1u;
+
+	/// @return header for the pipeline cache data produced by a device with given properties
+	auto pipecache_header(const vk::PhysicalDeviceProperties& props
+	                      , const std::vector<uint8_t>& data
+	                      )-> PipelineCacheHeader
+	{
+		auto r = PipelineCacheHeader{};
+		r.magic = pipecache_magic;
+		r.version = pipecache_version;
+		r.vendor_id = props.vendorID;
+		r.device_id = props.deviceID;
+		r.driver_version = props.driverVersion;
+		std::memcpy(r.uuid, &props.pipelineCacheUUID[0], VK_UUID_SIZE);
+		r.data_size = data.size();
+		r.checksum = vuh::hash_bytes(data.data(), data.size());
+		return r;
+	}
+
+	/// Read pipeline cache data from file.
+	/// @return cache data, or empty array if the file does not exist, is corrupted or was written
+	/// for a different device or driver version.
+	auto read_pipeline_cache(const std::string& filepath, const vk::PhysicalDeviceProperties& props
+	                         )-> std::vector<uint8_t>
+	{
+		auto fin = std::ifstream(filepath, std::ios::binary);
+		if(!fin.is_open()){
+			return {};
+		}
+		auto header = PipelineCacheHeader{};
+		if(!fin.read(reinterpret_cast<char*>(&header), sizeof(header))){
+			return {};
+		}
+		const auto ref = pipecache_header(props, {});
+		if(header.magic != ref.magic
+		   || header.version != ref.version
+		   || header.vendor_id != ref.vendor_id
+		   || header.device_id != ref.device_id
+		   || header.driver_version != ref.driver_version
+		   || 0 != std::memcmp(header.uuid, ref.uuid, VK_UUID_SIZE)
+		   || header.data_size > std::numeric_limits<uint32_t>::max())
+		{
+			return {};
+		}
+		auto r = std::vector<uint8_t>(header.data_size);
+		if(!fin.read(reinterpret_cast<char*>(r.data()), std::streamsize(r.size()))
+		   || header.checksum != vuh::hash_bytes(r.data(), r.size()))
+		{
+			return {};
+		}
+		return r;
+	}
+
+	/// Write pipeline cache data to file.
+	/// @throws vuh::FileWriteFailure
+	auto write_pipeline_cache(const std::string& filepath, const vk::PhysicalDeviceProperties& props
+	                          , const std::vector<uint8_t>& data
+	                          )-> void
+	{
+		write_file_atomic(filepath, [&](std::ostream& fout){
+			const auto header = pipecache_header(props, data);
+			return bool(fout.write(reinterpret_cast<const char*>(&header), sizeof(header)))
+			    && bool(fout.write(reinterpret_cast<const char*>(data.data())
+			                       , std::streamsize(data.size())));
+		});
+	}
+
+	/// Record of the tuning database file.
+	/// Database is a text file with one record per line, so that it can be inspected and edited
+	/// by hand and records of different devices may live in the same file.
+	struct TuningRecord {
+		uint32_t vendor_id;      ///< vendor id of the physical device
+		uint32_t device_id;      ///< device id of the physical device
+		uint32_t driver_version; ///< driver version
+		uint64_t kernel_hash;    ///< hash of the kernel SPIR-V code
+		uint32_t value;          ///< tuned workgroup size
+
+		/// @return true if record was produced by a device with given properties
+		auto matches(const vk::PhysicalDeviceProperties& props) const-> bool {
+			return vendor_id == props.vendorID && device_id == props.deviceID
+			    && driver_version == props.driverVersion;
+		}
+	};
+
+	/// Read tuning database. Lines starting with '#' and malformed lines are skipped.
+	/// @return all records found in the file, empty array if file does not exist.
+	auto read_tuning(const std::string& filepath)-> std::vector<TuningRecord> {
+		auto r = std::vector<TuningRecord>{};
+		auto fin = std::ifstream(filepath);
+		for(auto line = std::string{}; std::getline(fin, line);){
+			if(line.empty() || line[0] == '#'){
+				continue;
+			}
+			auto rec = TuningRecord{};
+			auto in = std::istringstream(line);
+			if(in >> std::hex >> rec.vendor_id >> rec.device_id >> rec.driver_version
+			      >> rec.kernel_hash >> std::dec >> rec.value)
+			{
+				r.push_back(rec);
+			}
+		}
+		return r;
+	}
+
+	/// Write tuning database.
+	/// @throws vuh::FileWriteFailure
+	auto write_tuning(const std::string& filepath, const std::vector<TuningRecord>& records)-> void {
+		write_file_atomic(filepath, [&](std::ostream& fout){
+			fout << "# vuh tuning database: vendor_id device_id driver_version kernel_hash workgroup_size\n";
+			for(const auto& rec: records){
+				fout << std::hex << rec.vendor_id << ' ' << rec.device_id << ' ' << rec.driver_version
+				     << ' ' << rec.kernel_hash << ' ' << std::dec << rec.value << '\n';
+			}
+			return bool(fout);
+		});
+	}
+
+	/// Content bytes of the shared object given in pieces, so that the lookup does not copy them.
+	using KeyPieces = std::initializer_list<std::pair<const void*, std::size_t>>;
+
+	/// Take the shared object with a given content, or create it with a given function if there is
+	/// none yet. Either way the object gets one more user.
+	/// Objects are looked up by the hash of the content, which is then compared bytewise.
+	template<class Objects, class F>
+	auto acquire_shared(Objects& objects, KeyPieces key, F&& create)-> decltype(create()) {
+		auto hash = vuh::hash_bytes(nullptr, 0);
+		auto size = std::size_t(0);
+		for(const auto& k: key){
+			hash = vuh::hash_bytes(k.first, k.second, hash);
+			size += k.second;
+		}
+		auto same = [&](const std::string& bytes){
+			if(bytes.size() != size){
+				return false;
+			}
+			auto pos = std::size_t(0);
+			for(const auto& k: key){
+				if(k.second > 0 && std::memcmp(bytes.data() + pos, k.first, k.second) != 0){
+					return false;
+				}
+				pos += k.second;
+			}
+			return true;
+		};
+		const auto range = objects.equal_range(hash);
+		for(auto it = range.first; it != range.second; ++it){
+			if(same(it->second.key)){
+				++it->second.users;
+				return it->second.handle;
+			}
+		}
+		auto obj = typename Objects::mapped_type{create(), {}, 1u};
+		obj.key.reserve(size);
+		for(const auto& k: key){
+			obj.key.append(static_cast<const char*>(k.first), k.second);
+		}
+		const auto r = obj.handle;
+		objects.emplace(hash, std::move(obj));
+		return r;
+	}
+
+	/// Drop one user of the shared object, destroy the object with a given function when that
+	/// was the last one. Noop for null handles and objects not in the registry.
+	template<class Objects, class Handle, class F>
+	auto release_shared(Objects& objects, Handle handle, F&& destroy) noexcept-> void {
+		auto it = std::find_if(objects.begin(), objects.end()
+		                       , [handle](const auto& o){ return o.second.handle == handle; });
+		if(!handle || it == objects.end()){
+			return;
+		}
+		if(--it->second.users == 0){
+			destroy(handle);
+			objects.erase(it);
+		}
+	}
 } // namespace
 
 namespace vuh {
@@ -109,13 +559,22 @@ namespace vuh {
 				   , const std::vector<const char*>& extensions
 	               )
 		// TODO: are the two filter_extensions calls folded into one?
-	  : vk::Device(createDevice(physDevice, computeFamilyId, transferFamilyId, filter_extensions(physDevice, extensions)))
-	  , _extensions(filter_extensions(physDevice, extensions))
+	  : vk::Device(createDevice(instance, physDevice, computeFamilyId, transferFamilyId
+	                            , filter_extensions(physDevice, api_version(instance, physDevice)
+	                                                , extensions)))
+	  , _extensions(filter_extensions(physDevice, api_version(instance, physDevice), extensions))
 	  , _instance(instance)
 	  , _physdev(physDevice)
+	  , _properties(physDevice.getProperties())
+	  , _features(device_features(instance, physDevice, _extensions))
+	  , _shared_mutex(std::make_unique<std::mutex>())
+	  , _recycled(std::make_unique<detail::Recycled>())
 	  , _cmp_family_id(computeFamilyId)
 	  , _tfr_family_id(transferFamilyId)
 	{
+		if(computeFamilyId != uint32_t(-1)){
+			_timestamp_bits = physDevice.getQueueFamilyProperties()[computeFamilyId].timestampValidBits;
+		}
 		try {
 			_cmdpool_compute = createCommandPool({vk::CommandPoolCreateFlagBits::eResetCommandBuffer
 			                                     , computeFamilyId});
@@ -128,6 +587,29 @@ namespace vuh {
 				                 {vk::CommandPoolCreateFlagBits::eResetCommandBuffer, _tfr_family_id});
 				_cmdbuf_transfer = allocCmdBuffer(*this, _cmdpool_transfer);
 			}
+			_pipecache = createPipelineCache({});
+			if(hasExtension("VK_KHR_push_descriptor")){
+				_push_descriptor_fn = PFN_vkCmdPushDescriptorSetKHR(
+				                                          getProcAddr("vkCmdPushDescriptorSetKHR"));
+			}
+			if(_features.buffer_device_address){
+				_buffer_address_fn = PFN_vkGetBufferDeviceAddressKHR(
+				                                         getProcAddr("vkGetBufferDeviceAddressKHR"));
+				_features.buffer_device_address = _buffer_address_fn != nullptr;
+			}
+			if(hasExtension("VK_KHR_device_group")){
+				_dispatch_base_fn = PFN_vkCmdDispatchBaseKHR(getProcAddr("vkCmdDispatchBaseKHR"));
+			}
+			if(_features.timeline_semaphore){
+				_wait_semaphores_fn = PFN_vkWaitSemaphoresKHR(getProcAddr("vkWaitSemaphoresKHR"));
+				_features.timeline_semaphore = _wait_semaphores_fn != nullptr;
+			}
+			if(_features.timeline_semaphore){
+				_timeline_compute = createTimeline(*this);
+				if(_tfr_family_id != _cmp_family_id){
+					_timeline_transfer = createTimeline(*this);
+				}
+			}
 		} catch(vk::Error&) {
 			release(); // because vk::Device does not know how to clean after itself
 			throw;
@@ -137,6 +619,54 @@ namespace vuh {
 	/// release resources associated with device
 	auto Device::release() noexcept-> void {
 		if(static_cast<vk::Device&>(*this)){
+			if(_pipecache){
+				if(!_pipecache_path.empty()){
+					try {
+						savePipelineCache();
+					} catch(std::exception& e){
+						_instance.report("Device", e.what(), VK_DEBUG_REPORT_WARNING_BIT_EXT);
+					}
+				}
+				destroyPipelineCache(_pipecache);
+			}
+			// shared objects left here were not released by their users (programs outliving the device)
+			for(auto& o: _shared_pipelayouts){
+				destroyPipelineLayout(o.second.first);
+			}
+			for(auto& o: _shared_dsclayouts){
+				destroyDescriptorSetLayout(o.second.first);
+			}
+			for(auto& o: _shared_modules){
+				destroyShaderModule(o.second.first);
+			}
+			_shared_pipelayouts.clear();
+			_shared_dsclayouts.clear();
+			_shared_modules.clear();
+			if(_recycled){
+				for(auto f: _recycled->fences.objects){
+					destroyFence(f);
+				}
+				for(auto s: _recycled->semaphores.objects){
+					destroySemaphore(s);
+				}
+				const auto& compute_buffers = _recycled->compute_buffers.objects;
+				if(!compute_buffers.empty()){
+					freeCommandBuffers(_cmdpool_compute, uint32_t(compute_buffers.size())
+					                   , compute_buffers.data());
+				}
+				const auto& transfer_buffers = _recycled->transfer_buffers.objects;
+				if(!transfer_buffers.empty()){
+					freeCommandBuffers(_cmdpool_transfer, uint32_t(transfer_buffers.size())
+					                   , transfer_buffers.data());
+				}
+				_recycled.reset();
+			}
+			if(_timeline_transfer){
+				destroySemaphore(_timeline_transfer);
+			}
+			if(_timeline_compute){
+				destroySemaphore(_timeline_compute);
+			}
 			if(_tfr_family_id != _cmp_family_id){
 				freeCommandBuffers(_cmdpool_transfer, 1, &_cmdbuf_transfer);
 				destroyCommandPool(_cmdpool_transfer);
@@ -153,10 +683,18 @@ namespace vuh {
 		release();
 	}
 
-	/// Copy constructor. Creates new handle to the same physical device, and recreates associated pools
+	/// Copy constructor. Creates new handle to the same physical device, and recreates associated pools.
+	/// Pipeline cache of the new device is seeded with the content of the other one's.
 	Device::Device(const Device& other)
 	   : Device(other._instance, other._physdev, other._cmp_family_id, other._tfr_family_id, other._extensions)
-	{}
+	{
+		mergePipelineCache(other.getPipelineCacheData(other._pipecache));
+		_pipecache_path = other._pipecache_path;
+		_tuning = other._tuning;
+		_tuning_path = other._tuning_path;
+		_sync_spin = other._sync_spin;
+		_queue_sharing = other._queue_sharing;
+	}
 
 	/// Copy assignment. Created new handle to the same physical device and recreates associated pools.
 	auto Device::operator=(Device other)-> Device& {
@@ -170,10 +708,33 @@ namespace vuh {
 	   , _extensions(std::move(other._extensions))
 	   , _instance(other._instance)
 	   , _physdev(other._physdev)
+	   , _properties(other._properties)
+	   , _features(other._features)
 	   , _cmdpool_compute(other._cmdpool_compute)
 	   , _cmdbuf_compute(other._cmdbuf_compute)
+	   , _cmdbuf_compute_version(other._cmdbuf_compute_version)
 	   , _cmdpool_transfer(other._cmdpool_transfer)
 	   , _cmdbuf_transfer(other._cmdbuf_transfer)
+	   , _pipecache(other._pipecache)
+	   , _pipecache_path(std::move(other._pipecache_path))
+	   , _tuning(std::move(other._tuning))
+	   , _tuning_path(std::move(other._tuning_path))
+	   , _shared_modules(std::move(other._shared_modules))
+	   , _shared_dsclayouts(std::move(other._shared_dsclayouts))
+	   , _shared_pipelayouts(std::move(other._shared_pipelayouts))
+	   , _shared_mutex(std::move(other._shared_mutex))
+	   , _recycled(std::move(other._recycled))
+	   , _sync_spin(other._sync_spin)
+	   , _timeline_compute(other._timeline_compute)
+	   , _timeline_compute_value(other._timeline_compute_value)
+	   , _timeline_transfer(other._timeline_transfer)
+	   , _timeline_transfer_value(other._timeline_transfer_value)
+	   , _queue_sharing(other._queue_sharing)
+	   , _timestamp_bits(other._timestamp_bits)
+	   , _push_descriptor_fn(other._push_descriptor_fn)
+	   , _buffer_address_fn(other._buffer_address_fn)
+	   , _dispatch_base_fn(other._dispatch_base_fn)
+	   , _wait_semaphores_fn(other._wait_semaphores_fn)
 	   , _cmp_family_id(other._cmp_family_id)
 	   , _tfr_family_id(other._tfr_family_id)
 	{
@@ -191,45 +752,75 @@ namespace vuh {
 		using std::swap;
 		swap((vk::Device&)d1     , (vk::Device&)d2     );
 		swap(d1._physdev         , d2._physdev         );
+		swap(d1._properties      , d2._properties      );
+		swap(d1._features        , d2._features        );
 		swap(d1._cmdpool_compute , d2._cmdpool_compute );
 		swap(d1._cmdbuf_compute  , d2._cmdbuf_compute  );
+		swap(d1._cmdbuf_compute_version, d2._cmdbuf_compute_version);
 		swap(d1._cmdpool_transfer, d2._cmdpool_transfer);
 		swap(d1._cmdbuf_transfer , d2._cmdbuf_transfer );
+		swap(d1._pipecache       , d2._pipecache       );
+		swap(d1._pipecache_path  , d2._pipecache_path  );
+		swap(d1._tuning          , d2._tuning          );
+		swap(d1._tuning_path     , d2._tuning_path     );
+		swap(d1._shared_modules  , d2._shared_modules  );
+		swap(d1._shared_dsclayouts, d2._shared_dsclayouts);
+		swap(d1._shared_pipelayouts, d2._shared_pipelayouts);
+		swap(d1._shared_mutex    , d2._shared_mutex    );
+		swap(d1._recycled        , d2._recycled        );
+		swap(d1._sync_spin       , d2._sync_spin       );
+		swap(d1._timeline_compute, d2._timeline_compute);
+		swap(d1._timeline_compute_value, d2._timeline_compute_value);
+		swap(d1._timeline_transfer, d2._timeline_transfer);
+		swap(d1._timeline_transfer_value, d2._timeline_transfer_value);
+		swap(d1._queue_sharing   , d2._queue_sharing   );
+		swap(d1._timestamp_bits  , d2._timestamp_bits  );
+		swap(d1._push_descriptor_fn, d2._push_descriptor_fn);
+		swap(d1._buffer_address_fn, d2._buffer_address_fn);
+		swap(d1._dispatch_base_fn, d2._dispatch_base_fn);
+		swap(d1._wait_semaphores_fn, d2._wait_semaphores_fn);
 		swap(d1._cmp_family_id   , d2._cmp_family_id   );
 		swap(d1._tfr_family_id   , d2._tfr_family_id   );
 	}
 
-	/// @return physical device properties
-	auto Device::properties() const-> vk::PhysicalDeviceProperties {
-		return _physdev.getProperties();
-	}
-
 	/// @return memory properties of the memory with given id
 	auto Device::memoryProperties(uint32_t id) const-> vk::MemoryPropertyFlags {
 		return _physdev.getMemoryProperties().memoryTypes[id].propertyFlags;
 	}
 
+	/// @return properties (supported features) of the given format
+	auto Device::formatProperties(vk::Format format) const-> vk::FormatProperties {
+		return _physdev.getFormatProperties(format);
+	}
+
 	/// Find first memory matching desired properties.
 	/// Does NOT check for free space availability, only matches the properties.
 	/// @return id of the suitable memory, -1 if no suitable memory found.
 	auto Device::selectMemory(vk::Buffer buffer, vk::MemoryPropertyFlags properties
 	                          ) const-> uint32_t
 	{
-		auto memProperties = _physdev.getMemoryProperties();
-		auto memoryReqs = getBufferMemoryRequirements(buffer);
-		for(uint32_t i = 0; i < memProperties.memoryTypeCount; ++i){
-			if( (memoryReqs.memoryTypeBits & (1u << i))
-			    && ((properties & memProperties.memoryTypes[i].propertyFlags) == properties))
-			{
-				return i;
-			}
-		}
-		return uint32_t(-1);
+		return select_memory(_physdev.getMemoryProperties(), getBufferMemoryRequirements(buffer)
+		                     , properties);
+	}
+
+	/// Find first memory matching desired properties suitable for the image.
+	/// @return id of the suitable memory, -1 if no suitable memory found.
+	auto Device::selectMemory(vk::Image image, vk::MemoryPropertyFlags properties
+	                          ) const-> uint32_t
+	{
+		return select_memory(_physdev.getMemoryProperties(), getImageMemoryRequirements(image)
+		                     , properties);
+	}
+
+	/// @return Vulkan API version usable with this device, that is the lower of the one
+	/// the instance was created with and the one supported by the physical device
+	auto Device::apiVersion() const-> uint32_t {
+		return api_version(_instance, _physdev);
 	}
 
 	/// @return true if compute queues family is different from that for transfer queues
 	auto Device::hasSeparateQueues() const-> bool {
-		return _cmp_family_id == _tfr_family_id;
+		return _cmp_family_id != _tfr_family_id;
 	}
 
 	/// @return id of the queue family supporting compute operations
@@ -239,29 +830,301 @@ namespace vuh {
 
 	/// Create compute pipeline with a given layout.
 	/// Shader stage info incapsulates the shader and layout&values of specialization constants.
+	/// If base pipeline is given (flags should then include vk::PipelineCreateFlagBits::eDerivative)
+	/// the new pipeline is created as its derivative.
 	auto Device::createPipeline(vk::PipelineLayout pipe_layout
 	                            , vk::PipelineCache pipe_cache
 	                            , const vk::PipelineShaderStageCreateInfo& shader_stage_info
 	                            , vk::PipelineCreateFlags flags
+	                            , vk::Pipeline base_pipeline
 	                            )-> vk::Pipeline
 	{
 		auto pipelineCI = vk::ComputePipelineCreateInfo(flags
-																		, shader_stage_info, pipe_layout);
+																		, shader_stage_info, pipe_layout
+		                                                , base_pipeline, -1);
 		return createComputePipeline(pipe_cache, pipelineCI, nullptr);
 		
 	}
 
-	/// Detach the current compute command buffer for sync operations and create the new one.
+	/// Detach the current compute command buffer for sync operations and replace it with
+	/// the one from acquireComputeCmdBuffer().
 	/// @return the old buffer handle
 	auto Device::releaseComputeCmdBuffer()-> vk::CommandBuffer {
-		auto new_buffer = allocCmdBuffer(*this, _cmdpool_compute);
+		auto new_buffer = acquireComputeCmdBuffer();
 		std::swap(new_buffer, _cmdbuf_compute);
+		++_cmdbuf_compute_version;
 		if(_tfr_family_id == _cmp_family_id){
 			_cmdbuf_transfer = _cmdbuf_compute;
 		}
 		return new_buffer;
 	}
 
+	/// @return command buffer of the compute pool for the async operation, the recycled one
+	/// (see recycleComputeCmdBuffer()) if there is any, or the newly allocated.
+	auto Device::acquireComputeCmdBuffer()-> vk::CommandBuffer {
+		std::lock_guard<std::mutex> lock(_recycled->mutex); // pool is also externally synchronized
+		const auto r = _recycled->compute_buffers.take();
+		return r ? r : allocCmdBuffer(*this, _cmdpool_compute);
+	}
+
+	/// Keep the command buffer of the compute pool for reuse, once the work recorded to it
+	/// is complete. May be called from any thread.
+	auto Device::recycleComputeCmdBuffer(vk::CommandBuffer buffer) noexcept-> void {
+		std::lock_guard<std::mutex> lock(_recycled->mutex); // pool is also externally synchronized
+		try {
+			_recycled->compute_buffers.objects.push_back(buffer);
+		} catch(...) { // could not keep it, give it back to the pool
+			freeCommandBuffers(_cmdpool_compute, 1, &buffer);
+		}
+	}
+
+	/// @return command buffer of the transfer pool for the async operation, the recycled one
+	/// (see recycleTransferCmdBuffer()) if there is any, or the newly allocated.
+	auto Device::acquireTransferCmdBuffer()-> vk::CommandBuffer {
+		if(_cmdpool_transfer == _cmdpool_compute){
+			return acquireComputeCmdBuffer();
+		}
+		std::lock_guard<std::mutex> lock(_recycled->mutex); // pool is also externally synchronized
+		const auto r = _recycled->transfer_buffers.take();
+		return r ? r : allocCmdBuffer(*this, _cmdpool_transfer);
+	}
+
+	/// Keep the command buffer of the transfer pool for reuse, once the work recorded to it
+	/// is complete. May be called from any thread.
+	auto Device::recycleTransferCmdBuffer(vk::CommandBuffer buffer) noexcept-> void {
+		if(_cmdpool_transfer == _cmdpool_compute){
+			return recycleComputeCmdBuffer(buffer);
+		}
+		std::lock_guard<std::mutex> lock(_recycled->mutex); // pool is also externally synchronized
+		try {
+			_recycled->transfer_buffers.objects.push_back(buffer);
+		} catch(...) { // could not keep it, give it back to the pool
+			freeCommandBuffers(_cmdpool_transfer, 1, &buffer);
+		}
+	}
+
+	/// @return fence in unsignalled state, the recycled one (see recycleFence()) if there is any.
+	auto Device::acquireFence()-> vk::Fence {
+		auto r = vk::Fence{};
+		{
+			std::lock_guard<std::mutex> lock(_recycled->mutex);
+			r = _recycled->fences.take();
+		}
+		return r ? r : createFence(vk::FenceCreateInfo());
+	}
+
+	/// Reset the fence and keep it for reuse. The fence should not be in use by pending
+	/// submissions. May be called from any thread.
+	auto Device::recycleFence(vk::Fence fence) noexcept-> void {
+		if(vk::Device::resetFences(1, &fence) != vk::Result::eSuccess){
+			destroyFence(fence);
+			return;
+		}
+		try {
+			std::lock_guard<std::mutex> lock(_recycled->mutex);
+			_recycled->fences.objects.push_back(fence);
+		} catch(...) {
+			destroyFence(fence);
+		}
+	}
+
+	/// @return binary semaphore in unsignalled state, the recycled one (see recycleSemaphore())
+	/// if there is any.
+	auto Device::acquireSemaphore()-> vk::Semaphore {
+		auto r = vk::Semaphore{};
+		{
+			std::lock_guard<std::mutex> lock(_recycled->mutex);
+			r = _recycled->semaphores.take();
+		}
+		return r ? r : createSemaphore(vk::SemaphoreCreateInfo());
+	}
+
+	/// Keep the binary semaphore for reuse. The semaphore should be unsignalled and have
+	/// no pending waits, that is the submission waiting for it should be complete.
+	/// May be called from any thread.
+	auto Device::recycleSemaphore(vk::Semaphore semaphore) noexcept-> void {
+		try {
+			std::lock_guard<std::mutex> lock(_recycled->mutex);
+			_recycled->semaphores.objects.push_back(semaphore);
+		} catch(...) {
+			destroySemaphore(semaphore);
+		}
+	}
+
+	/// Block till the fence is signalled.
+	/// Polls the fence status for a given period first and only then blocks in the driver.
+	/// Spinning burns a CPU core but saves the thread wake-up latency, which matters for short
+	/// (tens of microseconds) operations.
+	auto Device::waitFence(vk::Fence fence, std::chrono::nanoseconds spin) const-> void {
+		if(spin.count() > 0){
+			using clock = std::chrono::steady_clock;
+			const auto deadline = clock::now() + spin;
+			do {
+				if(getFenceStatus(fence) == vk::Result::eSuccess){
+					return;
+				}
+			} while(clock::now() < deadline);
+		}
+		(void)waitForFences({fence}, true, uint64_t(-1));
+	}
+
+	/// Submit the command buffer to a given queue and wait till it completes.
+	/// Waits on the fence of this submission (from acquireFence()) rather than for the queue
+	/// to go idle, so work submitted later does not hold it, while the work submitted earlier
+	/// completes before the fence signals as usual. Spin period is passed to waitFence(), sync operations use syncSpin().
+	/// Submission starts after the given points on the device timelines are reached.
+	/// @pre waits may only be passed if device supports timeline semaphores
+	auto Device::submitSync(vk::Queue queue, vk::CommandBuffer cmd_buf
+	                        , std::chrono::nanoseconds spin
+	                        , const TimelinePoint* waits, uint32_t n_waits
+	                        )-> void
+	{
+		assert(n_waits == 0 || _features.timeline_semaphore);
+		const auto timeline_waits = TimelineWaits(waits, n_waits);
+		auto timeline_info = vk::TimelineSemaphoreSubmitInfoKHR(timeline_waits.count
+		                                                        , timeline_waits.values.data());
+		auto submit_info = vk::SubmitInfo(timeline_waits.count, timeline_waits.semaphores.data()
+		                                  , timeline_waits.stages.data(), 1, &cmd_buf);
+		if(timeline_waits.count > 0){
+			submit_info.pNext = &timeline_info;
+		}
+		auto fence = acquireFence();
+		try {
+			queue.submit({submit_info}, fence);
+			waitFence(fence, spin);
+		} catch(vk::Error&) {
+			destroyFence(fence);
+			throw;
+		}
+		recycleFence(fence);
+	}
+
+	/// Submit the command buffer to the compute queue.
+	/// Submission starts after the given points on the device timelines are reached.
+	/// @return handle signalled when the submitted work completes: the point on the compute queue
+	/// timeline if the device supports timeline semaphores, the fence from acquireFence() otherwise.
+	/// @pre waits may only be passed if device supports timeline semaphores
+	auto Device::submitComputeAsync(vk::CommandBuffer cmd_buf
+	                                , const TimelinePoint* waits, uint32_t n_waits
+	                                )-> Submission
+	{
+		return submitAsync(computeQueue(), _timeline_compute, _timeline_compute_value
+		                   , cmd_buf, waits, n_waits);
+	}
+
+	/// Submit the command buffer to the transfer queue, see submitComputeAsync().
+	/// Transfer queue shares the timeline with the compute one if both are of the same family.
+	auto Device::submitTransferAsync(vk::CommandBuffer cmd_buf
+	                                 , const TimelinePoint* waits, uint32_t n_waits
+	                                 )-> Submission
+	{
+		if(_tfr_family_id == _cmp_family_id){
+			return submitComputeAsync(cmd_buf, waits, n_waits);
+		}
+		return submitAsync(transferQueue(), _timeline_transfer, _timeline_transfer_value
+		                   , cmd_buf, waits, n_waits);
+	}
+
+	/// Submit the command buffer to the queue signalling the next value on its timeline, or
+	/// the fence if the timeline is null.
+	/// Queue operations are not synchronized, that is the submissions to the same queue should
+	/// not be made concurrently (like with any other use of the device queues).
+	auto Device::submitAsync(vk::Queue queue, vk::Semaphore timeline, uint64_t& timeline_value
+	                         , vk::CommandBuffer cmd_buf, const TimelinePoint* waits, uint32_t n_waits
+	                         )-> Submission
+	{
+		if(!timeline){
+			assert(n_waits == 0);
+			auto fence = acquireFence();
+			auto submit_info = vk::SubmitInfo(0, nullptr, nullptr, 1, &cmd_buf);
+			try {
+				queue.submit({submit_info}, fence);
+			} catch(vk::Error&) {
+				destroyFence(fence);
+				throw;
+			}
+			return Submission{fence, TimelinePoint{}};
+		}
+		const auto value = timeline_value + 1;
+		const auto timeline_waits = TimelineWaits(waits, n_waits);
+		auto timeline_info = vk::TimelineSemaphoreSubmitInfoKHR(timeline_waits.count
+		                                                        , timeline_waits.values.data()
+		                                                        , 1, &value);
+		auto submit_info = vk::SubmitInfo(timeline_waits.count, timeline_waits.semaphores.data()
+		                                  , timeline_waits.stages.data(), 1, &cmd_buf, 1, &timeline);
+		submit_info.pNext = &timeline_info;
+		queue.submit({submit_info}, nullptr);
+		timeline_value = value;
+		return Submission{nullptr, TimelinePoint{timeline, value}};
+	}
+
+	/// Wait till the timeline semaphore reaches the value of a given point, or the timeout
+	/// (nanoseconds) expires.
+	/// @return true if the point was reached
+	/// @pre device should support timeline semaphores
+	auto Device::waitTimeline(const TimelinePoint& point, uint64_t timeout) const noexcept-> bool {
+		assert(_wait_semaphores_fn);
+		auto info = vk::SemaphoreWaitInfoKHR({}, 1, &point.semaphore, &point.value);
+		return _wait_semaphores_fn(*this, reinterpret_cast<const VkSemaphoreWaitInfoKHR*>(&info)
+		                           , timeout) == VK_SUCCESS;
+	}
+
+	/// Create the buffer to be used by both compute and transfer queues.
+	/// With the concurrent sharing (see queueSharing()) and different compute and transfer queue
+	/// families the buffer is created concurrently shared by the two, exclusive otherwise.
+	auto Device::makeBuffer(vk::DeviceSize size_bytes, vk::BufferUsageFlags usage)-> vk::Buffer {
+		auto info = vk::BufferCreateInfo({}, size_bytes, usage);
+		const auto families = std::array<uint32_t, 2>{_cmp_family_id, _tfr_family_id};
+		if(_queue_sharing == QueueSharing::Concurrent && _tfr_family_id != _cmp_family_id){
+			info.sharingMode = vk::SharingMode::eConcurrent;
+			info.queueFamilyIndexCount = uint32_t(families.size());
+			info.pQueueFamilyIndices = families.data();
+		}
+		return createBuffer(info);
+	}
+
+	/// Record the release of the buffer range written by the transfer commands to the compute
+	/// queue family, if the ownership transfer is needed (queue families are different and
+	/// buffers are not shared concurrently).
+	/// The range may not be used by the transfer queue afterwards, and its content is undefined
+	/// till the compute queue records the returned barrier.
+	/// @return matching barrier to be recorded by the compute queue to acquire the range before
+	/// use, null buffer if no transfer is needed.
+	/// @pre command buffer should belong to the transfer pool and be in the recording state.
+	auto Device::releaseToCompute(vk::CommandBuffer cmd_buf, vk::Buffer buffer
+	                              , vk::DeviceSize offset, vk::DeviceSize size
+	                              )-> vk::BufferMemoryBarrier
+	{
+		if(_queue_sharing == QueueSharing::Concurrent || _tfr_family_id == _cmp_family_id){
+			return vk::BufferMemoryBarrier{};
+		}
+		const auto release = vk::BufferMemoryBarrier(vk::AccessFlagBits::eTransferWrite, {}
+		                                             , _tfr_family_id, _cmp_family_id
+		                                             , buffer, offset, size);
+		cmd_buf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer
+		                        , vk::PipelineStageFlagBits::eBottomOfPipe
+		                        , {}, 0, nullptr, 1, &release, 0, nullptr);
+		return vk::BufferMemoryBarrier({}, vk::AccessFlagBits::eShaderRead
+		                                   | vk::AccessFlagBits::eShaderWrite
+		                                   | vk::AccessFlagBits::eIndirectCommandRead
+		                               , _tfr_family_id, _cmp_family_id, buffer, offset, size);
+	}
+
+	/// @return usage counters of the lists of fences, command buffers and semaphores kept
+	/// for reuse by the device.
+	/// With the steady stream of async operations the hit rates approach 1 and the sizes stay
+	/// at the max number of operations in flight.
+	/// Transfer buffer counters stay at zeros if the transfer queue family is the compute one.
+	auto Device::poolStats() const-> PoolStats {
+		std::lock_guard<std::mutex> lock(_recycled->mutex);
+		auto r = PoolStats{};
+		r.fences = _recycled->fences.counters();
+		r.compute_buffers = _recycled->compute_buffers.counters();
+		r.transfer_buffers = _recycled->transfer_buffers.counters();
+		r.semaphores = _recycled->semaphores.counters();
+		return r;
+	}
+
 	/// @return i-th queue in the family supporting transfer commands.
 	auto Device::transferQueue(uint32_t i)-> vk::Queue {
 		return getQueue(_tfr_family_id, i);
@@ -278,5 +1141,210 @@ namespace vuh {
 	auto Device::transferCmdPool()-> vk::CommandPool { return _cmdpool_transfer; }
 
 	/// @return handle to command buffer for syncronous transfer commands
+	/// Transfer command buffer is the compute one if both queues are of the same family.
 	auto Device::transferCmdBuffer()-> vk::CommandBuffer& { return _cmdbuf_transfer; }
+
+	/// Start recording the compute command buffer anew. Commands recorded there before are
+	/// dropped, so the buffer version is bumped (see computeCmdBufferVersion()).
+	/// @return the compute command buffer in the recording state
+	auto Device::beginComputeCmdBuffer(vk::CommandBufferUsageFlags flags)-> vk::CommandBuffer {
+		_cmdbuf_compute.begin({flags});
+		++_cmdbuf_compute_version;
+		return _cmdbuf_compute;
+	}
+
+	/// Start recording the transfer command buffer anew.
+	/// That re-records the compute command buffer if both queues are of the same family.
+	/// @return the transfer command buffer in the recording state
+	auto Device::beginTransferCmdBuffer(vk::CommandBufferUsageFlags flags)-> vk::CommandBuffer {
+		_cmdbuf_transfer.begin({flags});
+		if(_tfr_family_id == _cmp_family_id){
+			++_cmdbuf_compute_version;
+		}
+		return _cmdbuf_transfer;
+	}
+
+	/// @return shader module made of the given SPIR-V code.
+	/// Modules are shared by all programs created on the device with the same code, so the code
+	/// loaded by several programs is only turned to a module once.
+	/// Each call should be paired with releaseShared() when the module is no longer used.
+	/// Shared objects may be taken and released from several threads.
+	auto Device::sharedShaderModule(const uint32_t* code, std::size_t size_bytes
+	                                , vk::ShaderModuleCreateFlags flags
+	                                )-> vk::ShaderModule
+	{
+		std::lock_guard<std::mutex> lock(*_shared_mutex);
+		return acquire_shared(_shared_modules, {{&flags, sizeof(flags)}, {code, size_bytes}}, [&]{
+			return createShaderModule({flags, size_bytes, code});
+		});
+	}
+
+	/// @return descriptor set layout shared by all users passing the same key, that is the bytes
+	/// of its content (the key is up to the caller as it should cover the structures chained to info).
+	/// Each call should be paired with releaseShared() when the layout is no longer used.
+	auto Device::sharedDescriptorSetLayout(const std::string& key
+	                                       , const vk::DescriptorSetLayoutCreateInfo& info
+	                                       )-> vk::DescriptorSetLayout
+	{
+		std::lock_guard<std::mutex> lock(*_shared_mutex);
+		return acquire_shared(_shared_dsclayouts, {{key.data(), key.size()}}, [&]{
+			return createDescriptorSetLayout(info);
+		});
+	}
+
+	/// @return pipeline layout shared by all users passing the same key (bytes of its content).
+	/// Each call should be paired with releaseShared() when the layout is no longer used.
+	auto Device::sharedPipelineLayout(const std::string& key, const vk::PipelineLayoutCreateInfo& info
+	                                  )-> vk::PipelineLayout
+	{
+		std::lock_guard<std::mutex> lock(*_shared_mutex);
+		return acquire_shared(_shared_pipelayouts, {{key.data(), key.size()}}, [&]{
+			return createPipelineLayout(info);
+		});
+	}
+
+	/// Release the shared shader module. Module is destroyed when the last user releases it.
+	auto Device::releaseShared(vk::ShaderModule module) noexcept-> void {
+		std::lock_guard<std::mutex> lock(*_shared_mutex);
+		release_shared(_shared_modules, module, [this](auto m){ destroyShaderModule(m); });
+	}
+
+	/// Release the shared descriptor set layout. Layout is destroyed when the last user releases it.
+	auto Device::releaseShared(vk::DescriptorSetLayout layout) noexcept-> void {
+		std::lock_guard<std::mutex> lock(*_shared_mutex);
+		release_shared(_shared_dsclayouts, layout, [this](auto l){ destroyDescriptorSetLayout(l); });
+	}
+
+	/// Release the shared pipeline layout. Layout is destroyed when the last user releases it.
+	auto Device::releaseShared(vk::PipelineLayout layout) noexcept-> void {
+		std::lock_guard<std::mutex> lock(*_shared_mutex);
+		release_shared(_shared_pipelayouts, layout, [this](auto l){ destroyPipelineLayout(l); });
+	}
+
+	/// @return true if the device extension with a given name is enabled
+	auto Device::hasExtension(const char* name) const-> bool {
+		return contains(name, _extensions, [](const char* e){ return e; });
+	}
+
+	/// Record the push of descriptors (VK_KHR_push_descriptor) to the compute command buffer.
+	/// Descriptors are pushed to set 0 of the given pipeline layout, dstSet field of the writes is ignored.
+	/// @pre supportsPushDescriptors() should be true.
+	auto Device::cmdPushDescriptorSet(vk::CommandBuffer cmd_buffer, vk::PipelineLayout layout
+	                                  , uint32_t n_writes, const vk::WriteDescriptorSet* writes
+	                                  ) const-> void
+	{
+		assert(_push_descriptor_fn);
+		_push_descriptor_fn(cmd_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, n_writes
+		                    , reinterpret_cast<const VkWriteDescriptorSet*>(writes));
+	}
+
+	/// Record the dispatch of a grid of workgroups starting at non-zero base (VK_KHR_device_group).
+	/// Kernels see the base included in gl_WorkGroupID and gl_GlobalInvocationID, so a grid may be
+	/// split into several dispatches with no changes to the kernel.
+	/// Pipeline should be created with eDispatchBaseKHR flag.
+	/// @pre supportsDispatchBase() should be true.
+	auto Device::cmdDispatchBase(vk::CommandBuffer cmd_buffer, const std::array<uint32_t, 3>& base
+	                             , const std::array<uint32_t, 3>& count
+	                             ) const-> void
+	{
+		assert(_dispatch_base_fn);
+		_dispatch_base_fn(cmd_buffer, base[0], base[1], base[2], count[0], count[1], count[2]);
+	}
+
+	/// @return device address of the buffer (VK_KHR_buffer_device_address) to be passed to kernels
+	/// and dereferenced there. Buffer should be created with eShaderDeviceAddress usage flag and
+	/// bound to memory allocated with eDeviceAddress flag.
+	/// @throws vuh::ExtensionNotFound if device does not support buffer device address
+	auto Device::bufferDeviceAddress(vk::Buffer buffer) const-> uint64_t {
+		if(!_buffer_address_fn){
+			throw ExtensionNotFound("VK_KHR_buffer_device_address");
+		}
+		auto info = vk::BufferDeviceAddressInfoKHR(buffer);
+		return _buffer_address_fn(*this, reinterpret_cast<const VkBufferDeviceAddressInfoKHR*>(&info));
+	}
+
+	/// Make the device pipeline cache persistent.
+	/// Merges the content of the given file (if any) into the cache and remembers the path, so that
+	/// the cache is written back there on savePipelineCache() call and when the device is released.
+	/// Files written for a different device or driver version as well as corrupted files are ignored.
+	/// @return true if cache data was successfully loaded from the file.
+	auto Device::pipelineCacheFile(const std::string& filepath)-> bool {
+		_pipecache_path = filepath;
+		auto data = read_pipeline_cache(filepath, properties());
+		if(data.empty()){
+			_instance.report("Device", ("no valid pipeline cache found at " + filepath).c_str()
+			                 , VK_DEBUG_REPORT_INFORMATION_BIT_EXT);
+			return false;
+		}
+		mergePipelineCache(data);
+		return true;
+	}
+
+	/// Save pipeline cache to the file previously set with pipelineCacheFile().
+	/// Content written to that file by other processes since it was loaded is merged in first.
+	/// Noop if cache was not made persistent.
+	/// @throws vuh::FileWriteFailure
+	auto Device::savePipelineCache()-> void {
+		if(_pipecache_path.empty()){
+			return;
+		}
+		const auto props = properties();
+		mergePipelineCache(read_pipeline_cache(_pipecache_path, props));
+		write_pipeline_cache(_pipecache_path, props, getPipelineCacheData(_pipecache));
+	}
+
+	/// Merge pipeline cache data (as returned by vkGetPipelineCacheData) into the device cache.
+	/// Data incompatible with the device is silently ignored by the driver.
+	auto Device::mergePipelineCache(const std::vector<uint8_t>& data)-> void {
+		if(data.empty()){
+			return;
+		}
+		auto src = createPipelineCache({vk::PipelineCacheCreateFlags(), data.size(), data.data()});
+		mergePipelineCaches(_pipecache, {src});
+		destroyPipelineCache(src);
+	}
+
+	/// Make the tuned workgroup sizes persistent and load those stored for this device
+	/// (same vendor, device id and driver version) from the given file.
+	/// Tuning results (see vuh::autotune()) are then written there as they come.
+	/// @return true if any tuned values for the device were found in this file.
+	auto Device::tuningFile(const std::string& filepath)-> bool {
+		_tuning_path = filepath;
+		auto n_found = std::size_t(0);
+		for(const auto& rec: read_tuning(filepath)){
+			if(rec.matches(_properties)){
+				_tuning[rec.kernel_hash] = rec.value;
+				++n_found;
+			}
+		}
+		return n_found > 0;
+	}
+
+	/// @return tuned workgroup size for the kernel with given SPIR-V code hash, 0 if not known.
+	auto Device::tunedWorkgroupSize(uint64_t kernel_hash) const-> uint32_t {
+		auto it = _tuning.find(kernel_hash);
+		return it != _tuning.end() ? it->second : 0u;
+	}
+
+	/// Store the tuned workgroup size of the kernel with given SPIR-V code hash.
+	/// If tuning results were made persistent (see tuningFile()) the file is updated right away,
+	/// records of other kernels and devices written there by other processes are preserved.
+	/// @throws vuh::FileWriteFailure
+	auto Device::storeTunedWorkgroupSize(uint64_t kernel_hash, uint32_t workgroup_size)-> void {
+		_tuning[kernel_hash] = workgroup_size;
+		if(_tuning_path.empty()){
+			return;
+		}
+		auto records = read_tuning(_tuning_path);
+		auto it = std::find_if(begin(records), end(records), [&](const TuningRecord& rec){
+			return rec.matches(_properties) && rec.kernel_hash == kernel_hash;
+		});
+		if(it != end(records)){
+			it->value = workgroup_size;
+		} else {
+			records.push_back({_properties.vendorID, _properties.deviceID, _properties.driverVersion
+			                  , kernel_hash, workgroup_size});
+		}
+		write_tuning(_tuning_path, records);
+	}
 } // namespace vuh
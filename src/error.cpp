@@ -21,6 +21,16 @@ namespace vuh {
 	   : std::runtime_error(message)
 	{}
 
+	/// Constructs the exception object with explanatory string.
+	FileWriteFailure::FileWriteFailure(const std::string& message)
+	   : std::runtime_error(message)
+	{}
+
+	/// Constructs the exception object with explanatory string.
+	FileWriteFailure::FileWriteFailure(const char* message)
+	   : std::runtime_error(message)
+	{}
+
 	/// Constructs the exception object with explanatory string.
 	LayerNotFound::LayerNotFound(const std::string& message)
 	   : std::runtime_error(message)
@@ -41,4 +51,23 @@ namespace vuh {
 	   : std::runtime_error(message)
 	{}
 
+	/// Constructs the exception object with explanatory string.
+	FormatNotSupported::FormatNotSupported(const std::string& message)
+	   : std::runtime_error(message)
+	{}
+
+	/// Constructs the exception object with explanatory string.
+	FormatNotSupported::FormatNotSupported(const char* message)
+	   : std::runtime_error(message)
+	{}
+
+	/// Constructs the exception object with explanatory string.
+	CompilationFailure::CompilationFailure(const std::string& message)
+	   : std::runtime_error(message)
+	{}
+
+	/// Constructs the exception object with explanatory string.
+	CompilationFailure::CompilationFailure(const char* message)
+	   : std::runtime_error(message)
+	{}
 } // namespace vuh
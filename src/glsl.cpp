@@ -0,0 +1,143 @@
+#include <vuh/glsl.h>
+#include <vuh/error.h>
+#include <vuh/internal/utils.h>
+#include <vuh/utils.h>
+
+#ifdef VUH_WITH_GLSLANG
+#include <glslang/Public/ResourceLimits.h>
+#include <glslang/Public/ShaderLang.h>
+#include <glslang/SPIRV/GlslangToSpv.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace {
+	/// Version of the compiled code cache format. Bump to invalidate the caches written before.
+	constexpr uint64_t glsl_cache_version = 1;
+
+	/// @return hash identifying the compilation result of a given source with given definitions
+	/// for the given Vulkan version
+	auto glsl_hash(const std::string& source, const vuh::GlslDefines& defines, uint32_t api_version
+	               )-> uint64_t
+	{
+		auto r = vuh::hash_bytes(&glsl_cache_version, sizeof(glsl_cache_version));
+		r = vuh::hash_bytes(&api_version, sizeof(api_version), r);
+		r = vuh::hash_bytes(source.data(), source.size(), r);
+		for(const auto& d: defines){ // zero separators keep ("AB", "C") and ("A", "BC") apart
+			r = vuh::hash_bytes(d.first.c_str(), d.first.size() + 1, r);
+			r = vuh::hash_bytes(d.second.c_str(), d.second.size() + 1, r);
+		}
+		return r;
+	}
+
+	/// @return preamble text defining the given preprocessor definitions
+	auto glsl_preamble(const vuh::GlslDefines& defines)-> std::string {
+		auto r = std::string{};
+		for(const auto& d: defines){
+			r += "#define " + d.first + " " + d.second + "\n";
+		}
+		return r;
+	}
+
+#ifdef VUH_WITH_GLSLANG
+	/// Initializes glslang once per process, finalizes at exit.
+	struct GlslangProcess {
+		GlslangProcess(){ glslang::InitializeProcess(); }
+		~GlslangProcess(){ glslang::FinalizeProcess(); }
+	};
+
+	/// Compile GLSL compute shader to SPIR-V with glslang.
+	/// @throws vuh::CompilationFailure
+	auto compile(const std::string& source, const vuh::GlslDefines& defines, uint32_t api_version
+	             )-> std::vector<char>
+	{
+		static const GlslangProcess process;
+		(void)process;
+
+		const auto vk11 = api_version >= VK_API_VERSION_1_1;
+		glslang::TShader shader(EShLangCompute);
+		auto text = source.c_str();
+		shader.setStrings(&text, 1);
+		const auto preamble = glsl_preamble(defines);
+		shader.setPreamble(preamble.c_str());
+		shader.setEnvInput(glslang::EShSourceGlsl, EShLangCompute, glslang::EShClientVulkan, 100);
+		shader.setEnvClient(glslang::EShClientVulkan, vk11 ? glslang::EShTargetVulkan_1_1
+		                                                  : glslang::EShTargetVulkan_1_0);
+		shader.setEnvTarget(glslang::EShTargetSpv, vk11 ? glslang::EShTargetSpv_1_3
+		                                                : glslang::EShTargetSpv_1_0);
+		const auto messages = EShMessages(EShMsgSpvRules | EShMsgVulkanRules);
+		if(!shader.parse(GetDefaultResources(), 100, false, messages)){
+			throw vuh::CompilationFailure(shader.getInfoLog());
+		}
+		glslang::TProgram program;
+		program.addShader(&shader);
+		if(!program.link(messages)){
+			throw vuh::CompilationFailure(program.getInfoLog());
+		}
+		auto spirv = std::vector<uint32_t>{};
+		glslang::GlslangToSpv(*program.getIntermediate(EShLangCompute), spirv);
+		auto r = std::vector<char>(spirv.size()*sizeof(uint32_t));
+		std::memcpy(r.data(), spirv.data(), r.size());
+		return r;
+	}
+#else
+	auto compile(const std::string&, const vuh::GlslDefines&, uint32_t)-> std::vector<char> {
+		throw vuh::CompilationFailure("vuh is built without glslang (VUH_WITH_GLSLANG is off)");
+	}
+#endif
+} // namespace
+
+namespace vuh {
+	/// @return true if vuh is built with glslang, so that compile_glsl() can compile
+	/// (and not only take the results from cache)
+	auto glsl_supported()-> bool {
+#ifdef VUH_WITH_GLSLANG
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/// @return path of the file in the cache directory the code compiled from a given source
+	/// with given definitions is stored to (and looked up at) by compile_glsl().
+	/// Kernels compiled in advance may be put there for the builds without glslang.
+	auto glsl_cache_path(const std::string& source ///< GLSL compute shader source
+	                     , const GlslDefines& defines ///< preprocessor definitions
+	                     , const std::string& cache_dir ///< directory of the compiled code cache
+	                     , uint32_t api_version ///< Vulkan version to compile for
+	                     )-> std::string
+	{
+		return spirv_cache_path(cache_dir, glsl_hash(source, defines, api_version));
+	}
+
+	/// Compile GLSL compute shader source to SPIR-V code suitable to create the vuh::Program.
+	/// Definitions are prepended to the source (after the #version directive) as #define-s,
+	/// so sizes and other values known at run time can be baked into the kernel as
+	/// compile-time constants.
+	/// If cache directory is given, the compiled code is looked up there first by the hash of
+	/// source, definitions and Vulkan version, and stored there after compilation. The directory
+	/// should exist. Cached code is reused even if vuh is built without glslang.
+	/// @throws vuh::CompilationFailure if the source does not compile or vuh is built without glslang.
+	/// @throws vuh::FileWriteFailure if compiled code could not be stored to cache.
+	auto compile_glsl(const std::string& source ///< GLSL compute shader source
+	                  , const GlslDefines& defines ///< preprocessor definitions
+	                  , const std::string& cache_dir ///< directory of the compiled code cache, empty for no caching
+	                  , uint32_t api_version ///< Vulkan version to compile for (1.1 is needed for subgroup operations)
+	                  )-> std::vector<char>
+	{
+		if(cache_dir.empty()){
+			return compile(source, defines, api_version);
+		}
+		const auto path = glsl_cache_path(source, defines, cache_dir, api_version);
+		auto r = read_cached_spirv(path);
+		if(r.empty()){
+			r = compile(source, defines, api_version);
+			write_file_atomic(path, [&](std::ostream& fout){
+				return bool(fout.write(r.data(), std::streamsize(r.size())));
+			});
+		}
+		return r;
+	}
+} // namespace vuh
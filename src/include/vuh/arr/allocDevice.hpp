@@ -27,24 +27,31 @@ public:
 	                      )-> vk::Buffer
 	{
 		const auto flags_combined = flags | vk::BufferUsageFlags(Props::buffer);
-		return device.createBuffer({ {}, size_bytes, flags_combined});
+		return device.makeBuffer(size_bytes, flags_combined);
 	}
 
 	/// Allocate memory for the buffer.
 	auto allocMemory(vuh::Device& device  ///< device to allocate memory
 	                 , vk::Buffer buffer  ///< buffer to allocate memory for
 	                 , vk::MemoryPropertyFlags flags_memory={} ///< additional (to the ones defined in Props) memory property flags
+	                 , vk::MemoryAllocateFlags flags_alloc={}  ///< memory allocation flags (i.e. eDeviceAddress)
 	                 )-> vk::DeviceMemory 
 	{
 		_memid = findMemory(device, buffer, flags_memory);
 		auto mem = vk::DeviceMemory{};
 		try{
-			mem = device.allocateMemory({device.getBufferMemoryRequirements(buffer).size, _memid});
+			auto allocInfo = vk::MemoryAllocateInfo(device.getBufferMemoryRequirements(buffer).size
+			                                        , _memid);
+			auto flagsInfo = vk::MemoryAllocateFlagsInfoKHR(flags_alloc);
+			if(flags_alloc){
+				allocInfo.pNext = &flagsInfo;
+			}
+			mem = device.allocateMemory(allocInfo);
 		} catch (vk::Error& e){
 			auto allocFallback = AllocFallback{};
 			device.instance().report("AllocDevice failed to allocate memory, using fallback", e.what()
 			                         , VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT);
-			mem = allocFallback.allocMemory(device, buffer, flags_memory);
+			mem = allocFallback.allocMemory(device, buffer, flags_memory, flags_alloc);
 			_memid = allocFallback.memId();
 		}
 		return mem;
@@ -96,7 +103,9 @@ public:
 	using properties_t = void;
 	
 	/// @throws vk::OutOfDeviceMemoryError
-	auto allocMemory(vuh::Device&, vk::Buffer, vk::MemoryPropertyFlags)-> vk::DeviceMemory {
+	auto allocMemory(vuh::Device&, vk::Buffer, vk::MemoryPropertyFlags, vk::MemoryAllocateFlags
+	                 )-> vk::DeviceMemory
+	{
 		throw vk::OutOfDeviceMemoryError("failed to allocate device memory"
 		                                 " and no fallback available");
 	}
@@ -115,7 +124,7 @@ public:
 	                      , vk::BufferUsageFlags flags ///< additional buffer usage flags
 	                      )-> vk::Buffer
 	{
-		return device.createBuffer({ {}, size_bytes, flags});
+		return device.makeBuffer(size_bytes, flags);
 	}
 	
 	/// @throw std::logic_error
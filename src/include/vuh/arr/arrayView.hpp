@@ -1,22 +1,95 @@
 #pragma once
 
+#include <vuh/device.h>
+
+#include <vulkan/vulkan.hpp>
+
 #include <cassert>
+#include <cstddef>
+#include <stdexcept>
 
 namespace vuh {
+	namespace detail {
+		/// @return dynamic counterpart of a buffer descriptor type (the one taking the offset at bind time).
+		/// Types having no dynamic counterpart are returned as is.
+		constexpr auto dynamic_descriptor(vk::DescriptorType t)-> vk::DescriptorType {
+			return t == vk::DescriptorType::eStorageBuffer ? vk::DescriptorType::eStorageBufferDynamic
+			     : t == vk::DescriptorType::eUniformBuffer ? vk::DescriptorType::eUniformBufferDynamic
+			     : t;
+		}
+
+		/// @return non-dynamic counterpart of a buffer descriptor type
+		constexpr auto static_descriptor(vk::DescriptorType t)-> vk::DescriptorType {
+			return t == vk::DescriptorType::eStorageBufferDynamic ? vk::DescriptorType::eStorageBuffer
+			     : t == vk::DescriptorType::eUniformBufferDynamic ? vk::DescriptorType::eUniformBuffer
+			     : t;
+		}
+
+		/// @return true if descriptor of a given type takes its offset at bind time
+		constexpr auto is_dynamic_descriptor(vk::DescriptorType t)-> bool {
+			return t == vk::DescriptorType::eStorageBufferDynamic
+			    || t == vk::DescriptorType::eUniformBufferDynamic;
+		}
+
+		/// @return true if descriptor of a given type refers to a buffer view rather than a buffer range
+		constexpr auto is_texel_descriptor(vk::DescriptorType t)-> bool {
+			return t == vk::DescriptorType::eUniformTexelBuffer
+			    || t == vk::DescriptorType::eStorageTexelBuffer;
+		}
+
+		/// @return true if descriptor of a given type refers to an image rather than a buffer
+		constexpr auto is_image_descriptor(vk::DescriptorType t)-> bool {
+			return t == vk::DescriptorType::eStorageImage
+			    || t == vk::DescriptorType::eSampledImage
+			    || t == vk::DescriptorType::eCombinedImageSampler;
+		}
+
+		/// @return min alignment (bytes) of offsets of buffers bound to descriptor of a given type
+		inline auto min_offset_alignment(const vk::PhysicalDeviceLimits& limits
+		                                 , vk::DescriptorType t
+		                                 )-> vk::DeviceSize
+		{
+			return static_descriptor(t) == vk::DescriptorType::eUniformBuffer
+			       ? limits.minUniformBufferOffsetAlignment
+			       : is_texel_descriptor(t) ? limits.minTexelBufferOffsetAlignment
+			                                : limits.minStorageBufferOffsetAlignment;
+		}
+
+		/// @return greatest common divisor
+		constexpr auto gcd(std::size_t a, std::size_t b)-> std::size_t {
+			return b == 0 ? a : gcd(b, a % b);
+		}
+	} // namespace detail
+
 	/// Read-write view into the continuous portion of some vuh::Array
 	/// Maybe used in place of array references in copy routines and kernel invocations
 	/// to pass parts of the array data.
+	/// When bound to a kernel the view is passed as a dynamic buffer descriptor, so rebinding the
+	/// views differing only by their offsets (like tiles of the same array) does not update the
+	/// descriptor set but just passes the new offsets.
+	/// Offset of the view in bytes should be a multiple of device's minStorageBufferOffsetAlignment
+	/// (minUniformBufferOffsetAlignment for uniform arrays, see aligned_offset()), as required
+	/// for any buffer range bound to kernels.
 	template<class Array>
 	class ArrayView {
 	public:
 		using array_type = Array;
 		using value_type = typename Array::value_type;
-		static constexpr auto descriptor_class = Array::descriptor_class;
+		static constexpr auto descriptor_class = detail::dynamic_descriptor(Array::descriptor_class);
 
 		/// Constructor
+		/// @throws std::invalid_argument if the offset does not match the device's min offset
+		/// alignment (see aligned_offset())
 		explicit ArrayView(Array& array, std::size_t offset_begin, std::size_t offset_end)
 		   : _array(&array), _offset_begin(offset_begin), _offset_end(offset_end)
-		{}
+		{
+			const auto alignment = detail::min_offset_alignment(array.device().properties().limits
+			                                                    , descriptor_class);
+			if(offset_begin*sizeof(value_type) % alignment != 0){
+				throw std::invalid_argument("array view offset does not match device's min offset"
+				                            " alignment, use vuh::aligned_offset() to pad the views");
+			}
+		}
 
 		/// @return reference to Vulkan buffer of the corresponding array
 		auto buffer()-> vk::Buffer& { return *_array; }
@@ -26,6 +99,15 @@ namespace vuh {
 		auto size() const-> std::size_t {return _offset_end - _offset_begin;}
 		/// @return number of bytes in the view
 		auto size_bytes() const-> std::size_t {return size()*sizeof(value_type);}
+		/// @return reference to device where the underlying array is allocated
+		auto device()-> vuh::Device& { return _array->device(); }
+		/// @return id of the underlying array
+		auto id() const-> uint64_t { return _array->id(); }
+		/// @return device address of the first element of the view
+		/// @pre underlying array should be created with eShaderDeviceAddressKHR usage flag.
+		auto device_address() const-> uint64_t {
+			return _array->device_address() + _offset_begin*sizeof(value_type);
+		}
 	private: // data
 		Array* _array;             ///< referes to underlying array object
 		std::size_t _offset_begin; ///< offset (number of array elements) of the beginning of the span
@@ -37,4 +119,16 @@ namespace vuh {
 	auto array_view(Array& array, std::size_t offset_begin, size_t offset_end)-> ArrayView<Array>{
 		return ArrayView<Array>(array, offset_begin, offset_end);
 	}
+
+	/// @return smallest offset (number of elements) not less than the given one at which the view
+	/// into given array may start to be bound to kernels.
+	/// Use it to pad the tiles when splitting an array into views.
+	template<class Array>
+	auto aligned_offset(Array& array, std::size_t offset)-> std::size_t {
+		using T = typename Array::value_type;
+		const auto alignment = std::size_t(detail::min_offset_alignment(array.device().properties().limits
+		                                                                , Array::descriptor_class));
+		const auto step = alignment/detail::gcd(alignment, sizeof(T)); // in elements
+		return (offset + step - 1)/step*step;
+	}
 } // namespace vuh
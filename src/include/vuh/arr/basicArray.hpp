@@ -3,6 +3,8 @@
 #include "allocDevice.hpp"
 
 #include <vuh/device.h>
+#include <vuh/error.h>
+#include <vuh/utils.h>
 
 #include <vulkan/vulkan.hpp>
 
@@ -20,20 +22,26 @@ class BasicArray: public vk::Buffer {
 public:
 	static constexpr auto descriptor_class = vk::DescriptorType::eStorageBuffer;
 
-	/// Construct SBO array of given size in device memory
+	/// Construct SBO array of given size in device memory.
+	/// Arrays holding indirect dispatch arguments (see Program::run_indirect()) should be created
+	/// with vk::BufferUsageFlagBits::eIndirectBuffer usage.
 	BasicArray(vuh::Device& device                     ///< device to allocate array
 	           , size_t size_bytes                     ///< desired size in bytes
 	           , vk::MemoryPropertyFlags properties={} ///< additional memory property flags. These are 'added' to flags defind by allocator.
 	           , vk::BufferUsageFlags usage={}         ///< additional usage flagsws. These are 'added' to flags defined by allocator.
 	           )
-	   : vk::Buffer(Alloc::makeBuffer(device, size_bytes, descriptor_flags | usage))
-	   , _dev(device)
+	   : vk::Buffer(Alloc::makeBuffer(device, size_bytes, descriptor_flags | checkUsage(device, usage)))
+	   , _dev(&device)
+	   , _id(unique_id())
    {
       try{
          auto alloc = Alloc();
-         _mem = alloc.allocMemory(device, *this, properties);
+         const auto flags_alloc = (usage & vk::BufferUsageFlagBits::eShaderDeviceAddressKHR)
+                                  ? vk::MemoryAllocateFlags(vk::MemoryAllocateFlagBits::eDeviceAddressKHR)
+                                  : vk::MemoryAllocateFlags();
+         _mem = alloc.allocMemory(device, *this, properties, flags_alloc);
          _flags = alloc.memoryProperties(device);
-         _dev.bindBufferMemory(*this, _mem, 0);
+         _dev->bindBufferMemory(*this, _mem, 0);
       } catch(std::runtime_error&){ // destroy buffer if memory allocation was not successful
          release();
          throw;
@@ -49,6 +57,7 @@ public:
 	/// Move constructor. Passes the underlying buffer ownership.
 	BasicArray(BasicArray&& other) noexcept
 	   : vk::Buffer(other), _mem(other._mem), _flags(other._flags), _dev(other._dev)
+	   , _id(other._id)
 	{
 		static_cast<vk::Buffer&>(other) = nullptr;
 	}
@@ -61,7 +70,15 @@ public:
 	auto offset() const-> std::size_t { return 0;}
 
 	/// @return reference to device on which underlying buffer is allocated
-	auto device()-> vuh::Device& { return _dev; }
+	auto device()-> vuh::Device& { return *_dev; }
+
+	/// @return id of the array. Unlike the buffer handle it is never reused by the other arrays.
+	auto id() const-> uint64_t { return _id; }
+
+	/// @return device address of the buffer. That can be passed to kernels (i.e. in push constants
+	/// or other arrays) and dereferenced there (GL_EXT_buffer_reference).
+	/// @pre array should be created with vk::BufferUsageFlagBits::eShaderDeviceAddressKHR usage flag.
+	auto device_address() const-> uint64_t { return _dev->bufferDeviceAddress(*this); }
 
 	/// @return true if array is host-visible, ie can expose its data via a normal host pointer.
 	auto isHostVisible() const-> bool {
@@ -76,31 +93,46 @@ public:
 		_mem = other._mem;
 		_flags = other._flags;
 		_dev = other._dev;
-		reinterpret_cast<vk::Buffer&>(*this) = reinterpret_cast<vk::Buffer&>(other);
-		reinterpret_cast<vk::Buffer&>(other) = nullptr;
+		_id = other._id;
+		static_cast<vk::Buffer&>(*this) = static_cast<vk::Buffer&>(other);
+		static_cast<vk::Buffer&>(other) = nullptr;
 		return *this;
 	}
 	
 	/// swap the guts of two basic arrays
 	auto swap(BasicArray& other) noexcept-> void {
 		using std::swap;
-		swap(static_cast<vk::Buffer&>(&this), static_cast<vk::Buffer&>(other));
+		swap(static_cast<vk::Buffer&>(*this), static_cast<vk::Buffer&>(other));
 		swap(_mem, other._mem);
 		swap(_flags, other._flags);
 		swap(_dev, other._dev);
+		swap(_id, other._id);
 	}
 private: // helpers
+	/// @return usage flags unchanged
+	/// @throws vuh::ExtensionNotFound if device address usage is requested on the device not
+	/// supporting it.
+	static auto checkUsage(const vuh::Device& device, vk::BufferUsageFlags usage)-> vk::BufferUsageFlags {
+		if((usage & vk::BufferUsageFlagBits::eShaderDeviceAddressKHR)
+		   && !device.features().buffer_device_address)
+		{
+			throw ExtensionNotFound("VK_KHR_buffer_device_address");
+		}
+		return usage;
+	}
+
 	/// release resources associated with current BasicArray object
 	auto release() noexcept-> void {
 		if(static_cast<vk::Buffer&>(*this)){
-			_dev.freeMemory(_mem);
-			_dev.destroyBuffer(*this);
+			_dev->freeMemory(_mem);
+			_dev->destroyBuffer(*this);
 		}
 	}
 protected: // data
 	vk::DeviceMemory _mem;           ///< associated chunk of device memory
 	vk::MemoryPropertyFlags _flags;  ///< actual flags of allocated memory (may differ from those requested)
-	vuh::Device& _dev;               ///< referes underlying logical device
+	vuh::Device* _dev;               ///< referes underlying logical device
+	uint64_t _id;                    ///< unique id of the array (see id())
 }; // class BasicArray
 } // namespace arr
 } // namespace vuh
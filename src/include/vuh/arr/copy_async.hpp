@@ -6,7 +6,10 @@
 #include <vuh/traits.hpp>
 #include <vuh/resource.hpp>
 
+#include <cassert>
+#include <cstddef>
 #include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -14,23 +17,22 @@ namespace vuh {
 	namespace detail {
 		/// Command buffer data packed with allocation and deallocation methods.
 		struct _CmdBuffer {
-			/// Constructor. Creates the new command buffer on a provided device and manages its resources.
-			_CmdBuffer(vuh::Device& device): device(&device){
-				auto bufferAI = vk::CommandBufferAllocateInfo(device.transferCmdPool()
-																			 , vk::CommandBufferLevel::ePrimary, 1);
-				cmd_buffer = device.allocateCommandBuffers(bufferAI)[0];
-			}
+			/// Constructor. Takes the command buffer of the transfer pool from the device
+			/// (recycled one if there is any) and manages its resources.
+			_CmdBuffer(vuh::Device& device)
+			   : cmd_buffer(device.acquireTransferCmdBuffer()), device(&device)
+			{}
 
 			/// Constructor. Takes ownership over the provided buffer.
-			/// @pre buffer should belong to the provided device. No check is made even in a debug build.
+			/// @pre buffer should belong to the transfer pool of the provided device. No check is made even in a debug build.
 			_CmdBuffer(vuh::Device& device, vk::CommandBuffer buffer)
 				: cmd_buffer(buffer), device(&device)
 			{}
 
-			/// Release the buffer resources
+			/// Release the buffer resources. Buffer goes back to the device for reuse.
 			auto release() noexcept-> void {
 				if(device){
-					device->freeCommandBuffers(device->transferCmdPool(), 1, &cmd_buffer);
+					device->recycleTransferCmdBuffer(cmd_buffer);
 				}
 			}
 		public: // data
@@ -51,9 +53,13 @@ namespace vuh {
 			/// delayed operation is a noop
 			constexpr auto operator()() const-> void {}
 
+			/// Record and submit the copy. If release is on the destination range is released to
+			/// the compute queue family (see Device::releaseToCompute()) and the returned token
+			/// carries the barrier acquiring it. Copies to the staging buffers are not released,
+			/// those are never used by the compute queue.
 			template<class Array1, class Array2>
 			auto copy_async(ArrayIter<Array1> src_begin, ArrayIter<Array1> src_end
-			                , ArrayIter<Array2> dst_begin
+			                , ArrayIter<Array2> dst_begin, bool release=true
 			                )-> Delayed<>
 			{
 				assert(device);
@@ -68,14 +74,14 @@ namespace vuh {
 				auto region = vk::BufferCopy(tsize*src_begin.offset(), tsize*dst_begin.offset()
 				                            , tsize*(src_end - src_begin));
 				cmd_buffer.copyBuffer(src_begin.array(), dst_begin.array(), 1, &region);
+				auto acquire = release ? device->releaseToCompute(cmd_buffer, dst_begin.array()
+				                                                  , region.dstOffset, region.size)
+				                       : vk::BufferMemoryBarrier{};
 				cmd_buffer.end();
 
-				auto queue = device->transferQueue();
-				auto submit_info = vk::SubmitInfo(0, nullptr, nullptr, 1, &cmd_buffer);
-				auto fence = device->createFence(vk::FenceCreateInfo());
-				queue.submit({submit_info}, fence);
-
-				return Delayed<>{fence, *device};
+				auto submission = device->submitTransferAsync(cmd_buffer);
+				submission.acquire = acquire;
+				return Delayed<>{submission, *device};
 			}
 		}; // struct CopyDevice
 
@@ -135,6 +141,9 @@ namespace vuh {
 		class ICopy{
 		public:
 			virtual auto operator()() const-> void = 0;
+			/// Move the object to the given storage.
+			/// @return pointer to the object constructed there
+			virtual auto move_to(void* storage) noexcept-> ICopy* = 0;
 			virtual ~ICopy() = default;
 		};
 
@@ -145,6 +154,9 @@ namespace vuh {
 		public:
 			CopyWrapper(T&& t): T(std::move(t)) {}
 			auto operator()() const-> void override { return T::operator()();}
+			auto move_to(void* storage) noexcept-> ICopy* override {
+				return new(storage) CopyWrapper(std::move(static_cast<T&>(*this)));
+			}
 			~CopyWrapper() override = default;
 		};
 	} // namespace detail
@@ -152,13 +164,46 @@ namespace vuh {
 	/// Type erasure over movable classes providing operator()(void) const-> void.
 	/// Used to trigger some action (encoded in that operator()()) and/or extend resources
 	/// lifetime at/till the synchrnonization point.
+	/// Objects small enough (and nothrow movable) are stored in place, so wrapping the actions
+	/// of the device-to-device and host-visible copies does not allocate.
 	class Copy {
 	public:
-		/// Takes an object of some type T, creates a CopyWrapper<T> of it on the heap
-		/// and creates an object of Copy class on top of that.
-		template<class T> 
+		/// Max size (bytes) of the wrapped object stored in place
+		static constexpr std::size_t inline_size = 8*sizeof(void*);
+
+		/// Takes an object of some type T, creates a CopyWrapper<T> of it in place (or on
+		/// the heap if it does not fit) and creates an object of Copy class on top of that.
+		template<class T>
 		static auto wrap(T&& t)-> Copy {
-			return Copy(std::make_unique<detail::CopyWrapper<T>>(std::move(t)));
+			using Wrapper = detail::CopyWrapper<std::decay_t<T>>;
+			auto r = Copy();
+			if(sizeof(Wrapper) <= inline_size && alignof(Wrapper) <= alignof(Storage)
+			   && std::is_nothrow_move_constructible<std::decay_t<T>>::value)
+			{
+				r._obj = new(&r._storage) Wrapper(std::move(t));
+				r._inline = true;
+			} else {
+				r._obj = new Wrapper(std::move(t));
+			}
+			return r;
+		}
+
+		/// Destroy the wrapped object.
+		~Copy() noexcept { reset(); }
+
+		Copy(const Copy&) = delete;
+		auto operator= (const Copy&)-> Copy& = delete;
+
+		/// Move constructor.
+		Copy(Copy&& o) noexcept { take(o); }
+
+		/// Move assignment. Destroys the wrapped object before taking over the other one.
+		auto operator= (Copy&& o) noexcept-> Copy& {
+			if(this != &o){
+				reset();
+				take(o);
+			}
+			return *this;
 		}
 
 		/// Runs the operator() of underlying type-erased object.
@@ -168,9 +213,37 @@ namespace vuh {
 			(*_obj)();
 		}
 	private:
-		explicit Copy(std::unique_ptr<detail::ICopy>&& ptr): _obj(std::move(ptr)) {}
+		using Storage = std::aligned_storage_t<inline_size, alignof(std::max_align_t)>;
+
+		Copy() = default;
+
+		/// Take over the wrapped object of the other instance, moving it here if it is stored in place.
+		auto take(Copy& o) noexcept-> void {
+			if(o._inline){
+				_obj = o._obj->move_to(&_storage);
+				_inline = true;
+				o.reset();
+			} else {
+				_obj = o._obj;
+				_inline = false;
+				o._obj = nullptr;
+			}
+		}
+
+		/// Destroy the wrapped object.
+		auto reset() noexcept-> void {
+			if(_inline){
+				_obj->~ICopy();
+			} else {
+				delete _obj;
+			}
+			_obj = nullptr;
+			_inline = false;
+		}
 	private:
-		std::unique_ptr<detail::ICopy> _obj; ///< doc me
+		Storage _storage;              ///< storage of the wrapped object if it fits
+		detail::ICopy* _obj = nullptr; ///< wrapped object, in place or on the heap
+		bool _inline = false;          ///< true if the wrapped object is stored in place
 	};
 
 	/// Async copy between arrays allocated on the same device
@@ -225,7 +298,7 @@ namespace vuh {
 		auto& array = src_begin.array();
 		if(!array.isHostVisible()){ // device array is not host-visible
 			auto stage = detail::CopyStageToHost<T, DstIter>(array.device(), src_end - src_begin, dst_begin);
-			return Delayed<Copy>{ stage.copy_async(src_begin, src_end, device_begin(stage.array))
+			return Delayed<Copy>{ stage.copy_async(src_begin, src_end, device_begin(stage.array), false)
 			                    , Copy::wrap(std::move(stage))};
 		} else { // array is host visible
 			using SrcIter = ArrayIter<arr::DeviceArray<T, Alloc>>;
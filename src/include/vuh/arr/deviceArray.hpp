@@ -94,12 +94,12 @@ public:
 	   : DeviceArray(device, n_elements, flags_memory, flags_buffer)
 	{
 		using std::begin;
-		auto stage_buffer = HostArray<T, AllocDevice<properties::HostCoherent>>(Base::_dev, n_elements);
+		auto stage_buffer = HostArray<T, AllocDevice<properties::HostCoherent>>(*Base::_dev, n_elements);
 		auto stage_it = begin(stage_buffer);
 		for(size_t i = 0; i < n_elements; ++i, ++stage_it){
 			*stage_it = fun(i);
 		}
-		copyBuf(Base::_dev, stage_buffer, *this, size_bytes());
+		copyBuf(*Base::_dev, stage_buffer, *this, size_bytes());
 	}
    
 	/// Copy data from host range to array memory.
@@ -107,10 +107,10 @@ public:
 	auto fromHost(It1 begin, It2 end)-> void {
 		if(Base::isHostVisible()){
 			std::copy(begin, end, host_data());
-			Base::_dev.unmapMemory(Base::_mem);
+			Base::_dev->unmapMemory(Base::_mem);
 		} else { // memory is not host visible, use staging buffer
-			auto stage_buf = HostArray<T, AllocDevice<properties::HostCoherent>>(Base::_dev, begin, end);
-			copyBuf(Base::_dev, stage_buf, *this, size_bytes());
+			auto stage_buf = HostArray<T, AllocDevice<properties::HostCoherent>>(*Base::_dev, begin, end);
+			copyBuf(*Base::_dev, stage_buf, *this, size_bytes());
 		}
 	}
    
@@ -119,10 +119,10 @@ public:
 	auto fromHost(It1 begin, It2 end, size_t offset)-> void {
 		if(Base::isHostVisible()){
 			std::copy(begin, end, host_data() + offset);
-			Base::_dev.unmapMemory(Base::_mem);
+			Base::_dev->unmapMemory(Base::_mem);
 		} else { // memory is not host visible, use staging buffer
-			auto stage_buf = HostArray<T, AllocDevice<properties::HostCoherent>>(Base::_dev, begin, end);
-			copyBuf(Base::_dev, stage_buf, *this, size_bytes(), 0u, offset*sizeof(T));
+			auto stage_buf = HostArray<T, AllocDevice<properties::HostCoherent>>(*Base::_dev, begin, end);
+			copyBuf(*Base::_dev, stage_buf, *this, size_bytes(), 0u, offset*sizeof(T));
 		}
 	}
 
@@ -132,11 +132,11 @@ public:
    auto toHost(It copy_to) const-> void {
       if(Base::isHostVisible()){
          std::copy_n(host_data(), size(), copy_to);
-         Base::_dev.unmapMemory(Base::_mem);
+         Base::_dev->unmapMemory(Base::_mem);
       } else {
          using std::begin; using std::end;
-         auto stage_buf = HostArray<T, AllocDevice<properties::HostCached>>(Base::_dev, size());
-         copyBuf(Base::_dev, *this, stage_buf, size_bytes());
+         auto stage_buf = HostArray<T, AllocDevice<properties::HostCached>>(*Base::_dev, size());
+         copyBuf(*Base::_dev, *this, stage_buf, size_bytes());
          std::copy(begin(stage_buf), end(stage_buf), copy_to);
       }
    }
@@ -148,11 +148,11 @@ public:
       if(Base::isHostVisible()){
          auto copy_from = host_data();
          std::transform(copy_from, copy_from + size(), copy_to, std::forward<F>(fun));
-         Base::_dev.unmapMemory(Base::_mem);
+         Base::_dev->unmapMemory(Base::_mem);
       } else {
          using std::begin; using std::end;
-         auto stage_buf = HostArray<T, AllocDevice<properties::HostCached>>(Base::_dev, size());
-         copyBuf(Base::_dev, *this, stage_buf, size_bytes());
+         auto stage_buf = HostArray<T, AllocDevice<properties::HostCached>>(*Base::_dev, size());
+         copyBuf(*Base::_dev, *this, stage_buf, size_bytes());
          std::transform(begin(stage_buf), end(stage_buf), copy_to, std::forward<F>(fun));
       }
    }
@@ -167,11 +167,11 @@ public:
 		if(Base::isHostVisible()){
 			auto copy_from = host_data();
 			std::transform(copy_from, copy_from + size, copy_to, std::forward<F>(fun));
-			Base::_dev.unmapMemory(Base::_mem);
+			Base::_dev->unmapMemory(Base::_mem);
 		} else {
 			using std::begin; using std::end;
-			auto stage_buf = HostArray<T, AllocDevice<properties::HostCached>>(Base::_dev, size);
-			copyBuf(Base::_dev, *this, stage_buf, size_bytes());
+			auto stage_buf = HostArray<T, AllocDevice<properties::HostCached>>(*Base::_dev, size);
+			copyBuf(*Base::_dev, *this, stage_buf, size_bytes());
 			std::transform(begin(stage_buf), end(stage_buf), copy_to, std::forward<F>(fun));
 		}
 	}
@@ -182,12 +182,12 @@ public:
 		if(Base::isHostVisible()){
 			auto copy_from = host_data();
 			std::copy(copy_from + offset_begin, copy_from + offset_end, dst_begin);
-			Base::_dev.unmapMemory(Base::_mem);
+			Base::_dev->unmapMemory(Base::_mem);
 		} else {
 			using std::begin; using std::end;
-			auto stage_buf = HostArray<T, AllocDevice<properties::HostCached>>(Base::_dev
+			auto stage_buf = HostArray<T, AllocDevice<properties::HostCached>>(*Base::_dev
 			                                                          , offset_end - offset_begin);
-			copyBuf(Base::_dev, *this, stage_buf, size_bytes(), offset_begin, 0u);
+			copyBuf(*Base::_dev, *this, stage_buf, size_bytes(), offset_begin, 0u);
 			std::copy(begin(stage_buf), end(stage_buf), dst_begin);
 		}
 	}
@@ -218,12 +218,12 @@ public:
 private: // helpers
 	auto host_data()-> T* {
 		assert(Base::isHostVisible());
-		return static_cast<T*>(Base::_dev.mapMemory(Base::_mem, 0, size_bytes()));
+		return static_cast<T*>(Base::_dev->mapMemory(Base::_mem, 0, size_bytes()));
 	}
 
 	auto host_data() const-> const T* {
 		assert(Base::isHostVisible());
-		return static_cast<const T*>(Base::_dev.mapMemory(Base::_mem, 0, size_bytes()));
+		return static_cast<const T*>(Base::_dev->mapMemory(Base::_mem, 0, size_bytes()));
 	}
 private: // data
 	size_t _size; ///< number of elements. Actual allocated memory may be a bit bigger than necessary.
@@ -27,7 +27,7 @@ public:
 	          , vk::BufferUsageFlags flags_buffer={}    ///< additional (to defined by allocator) buffer usage flags
 	          )
 	   : BasicArray<Alloc>(device, n_elements*sizeof(T), flags_memory, flags_buffer)
-	   , _data(static_cast<T*>(Base::_dev.mapMemory(Base::_mem, 0, n_elements*sizeof(T))))
+	   , _data(static_cast<T*>(Base::_dev->mapMemory(Base::_mem, 0, n_elements*sizeof(T))))
 	   , _size(n_elements)
 	{}
 
@@ -67,7 +67,7 @@ public:
    /// Destroy array, and release all associated resources.
    ~HostArray() noexcept {
       if(_data) {
-         Base::_dev.unmapMemory(Base::_mem);
+         Base::_dev->unmapMemory(Base::_mem);
       }
    }
 
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "deviceArray.hpp"
+
+#include <vuh/device.h>
+#include <vuh/error.h>
+#include <vuh/traits.hpp>
+
+#include <vulkan/vulkan.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace vuh {
+namespace arr {
+
+/// Read-only array bound to kernels as a uniform texel buffer.
+/// Elements are stored in the given format (i.e. 16-bit floats, normalized integers) and converted
+/// by the hardware to the floating point (or integer) values on read
+/// (texelFetch() on samplerBuffer in a kernel).
+/// Type T is the host-side type of a single texel, its size should match the format texel size.
+/// Data exchange interface is that of DeviceArray. Views into texel arrays can not be bound
+/// to kernels.
+template<class T, class Alloc>
+class TexelArray: public DeviceArray<T, Alloc> {
+	using Base = DeviceArray<T, Alloc>;
+public:
+	static constexpr auto descriptor_class = vk::DescriptorType::eUniformTexelBuffer;
+
+	/// Create an instance of TexelArray with given number of elements. Memory is uninitialized.
+	/// @throws vuh::FormatNotSupported if format can not be used for uniform texel buffers
+	/// @throws std::length_error if array does not fit the device limits
+	TexelArray(vuh::Device& device   ///< device to create array on
+	           , vk::Format format   ///< format of array elements
+	           , size_t n_elements   ///< number of elements
+	           , vk::MemoryPropertyFlags flags_memory={} ///< additional (to defined by allocator) memory usage flags
+	           , vk::BufferUsageFlags flags_buffer={})   ///< additional (to defined by allocator) buffer usage flags
+	   : Base(device, n_elements, flags_memory, flags_buffer | vk::BufferUsageFlagBits::eUniformTexelBuffer)
+	   , _format(format)
+	{
+		init_view();
+	}
+
+	/// Create an instance of TexelArray and initialize memory by content of some host iterable.
+	/// @throws vuh::FormatNotSupported if format can not be used for uniform texel buffers
+	/// @throws std::length_error if array does not fit the device limits
+	template<class C, class=typename std::enable_if_t<vuh::traits::is_iterable<C>::value>>
+	TexelArray(vuh::Device& device  ///< device to create array on
+	           , vk::Format format  ///< format of array elements
+	           , const C& c         ///< iterable to initialize from
+	           , vk::MemoryPropertyFlags flags_memory={} ///< additional (to defined by allocator) memory usage flags
+	           , vk::BufferUsageFlags flags_buffer={})   ///< additional (to defined by allocator) buffer usage flags
+	   : Base(device, c, flags_memory, flags_buffer | vk::BufferUsageFlagBits::eUniformTexelBuffer)
+	   , _format(format)
+	{
+		init_view();
+	}
+
+	/// Release the buffer view. The rest is released by the base class.
+	~TexelArray() noexcept { release(); }
+
+	TexelArray(const TexelArray&) = delete;
+	TexelArray& operator= (const TexelArray&) = delete;
+
+	/// Move constructor.
+	TexelArray(TexelArray&& other) noexcept
+	   : Base(std::move(other)), _format(other._format), _view(other._view)
+	{
+		other._view = nullptr;
+	}
+
+	/// Move assignment. Resources associated with current array are released immidiately.
+	auto operator= (TexelArray&& other) noexcept-> TexelArray& {
+		release();
+		Base::operator=(std::move(other));
+		_format = other._format;
+		_view = other._view;
+		other._view = nullptr;
+		return *this;
+	}
+
+	/// @return buffer view interpreting the array elements in its format
+	auto view() const-> vk::BufferView { return _view; }
+
+	/// @return format of array elements
+	auto format() const-> vk::Format { return _format; }
+private: // helpers
+	/// Create the view of the whole buffer.
+	auto init_view()-> void {
+		auto& device = Base::device();
+		const auto features = device.formatProperties(_format).bufferFeatures;
+		if(!(features & vk::FormatFeatureFlagBits::eUniformTexelBuffer)){
+			throw FormatNotSupported("format " + vk::to_string(_format)
+			                         + " can not be used for uniform texel buffers");
+		}
+		if(Base::size() > device.properties().limits.maxTexelBufferElements){
+			throw std::length_error("texel array size exceeds device's maxTexelBufferElements");
+		}
+		_view = device.createBufferView({vk::BufferViewCreateFlags(), *this, _format, 0, VK_WHOLE_SIZE});
+	}
+
+	/// Destroy the buffer view
+	auto release() noexcept-> void {
+		if(_view){
+			Base::device().destroyBufferView(_view);
+			_view = nullptr;
+		}
+	}
+private: // data
+	vk::Format _format;     ///< format of array elements
+	vk::BufferView _view;   ///< view of the whole buffer
+}; // class TexelArray
+
+} // namespace arr
+} // namespace vuh
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "deviceArray.hpp"
+
+#include <vuh/device.h>
+#include <vuh/traits.hpp>
+
+#include <vulkan/vulkan.hpp>
+
+#include <stdexcept>
+#include <type_traits>
+
+namespace vuh {
+namespace arr {
+
+/// Read-only array bound to kernels as a uniform buffer.
+/// Suits small tables (of coefficients, etc) read uniformly by all invocations, such are served
+/// from constant caches, faster than storage buffers.
+/// Size of the array is limited by device's maxUniformBufferRange (usually 64KB).
+/// Data exchange interface is that of DeviceArray.
+template<class T, class Alloc>
+class UniformArray: public DeviceArray<T, Alloc> {
+	using Base = DeviceArray<T, Alloc>;
+public:
+	static constexpr auto descriptor_class = vk::DescriptorType::eUniformBuffer;
+
+	/// Create an instance of UniformArray with given number of elements. Memory is uninitialized.
+	/// @throws std::length_error if array does not fit the device limits
+	UniformArray(vuh::Device& device   ///< device to create array on
+	             , size_t n_elements   ///< number of elements
+	             , vk::MemoryPropertyFlags flags_memory={} ///< additional (to defined by allocator) memory usage flags
+	             , vk::BufferUsageFlags flags_buffer={})   ///< additional (to defined by allocator) buffer usage flags
+	   : Base(device, n_elements, flags_memory, flags_buffer | vk::BufferUsageFlagBits::eUniformBuffer)
+	{
+		check_range();
+	}
+
+	/// Create an instance of UniformArray and initialize memory by content of some host iterable.
+	/// @throws std::length_error if array does not fit the device limits
+	template<class C, class=typename std::enable_if_t<vuh::traits::is_iterable<C>::value>>
+	UniformArray(vuh::Device& device  ///< device to create array on
+	             , const C& c         ///< iterable to initialize from
+	             , vk::MemoryPropertyFlags flags_memory={} ///< additional (to defined by allocator) memory usage flags
+	             , vk::BufferUsageFlags flags_buffer={})   ///< additional (to defined by allocator) buffer usage flags
+	   : Base(device, c, flags_memory, flags_buffer | vk::BufferUsageFlagBits::eUniformBuffer)
+	{
+		check_range();
+	}
+
+	/// Create an instance of UniformArray and initialize it from a range of values.
+	/// @throws std::length_error if array does not fit the device limits
+	template<class It1, class It2>
+	UniformArray(vuh::Device& device  ///< device to create array on
+	             , It1 begin          ///< range begin
+	             , It2 end            ///< range end (points to one past the last element of the range)
+	             , vk::MemoryPropertyFlags flags_memory={} ///< additional (to defined by allocator) memory usage flags
+	             , vk::BufferUsageFlags flags_buffer={})   ///< additional (to defined by allocator) buffer usage flags
+	   : Base(device, begin, end, flags_memory, flags_buffer | vk::BufferUsageFlagBits::eUniformBuffer)
+	{
+		check_range();
+	}
+private: // helpers
+	/// @throws std::length_error if array size exceeds device's maxUniformBufferRange
+	auto check_range()-> void {
+		if(Base::size_bytes() > Base::device().properties().limits.maxUniformBufferRange){
+			throw std::length_error("uniform array size exceeds device's maxUniformBufferRange");
+		}
+	}
+}; // class UniformArray
+
+} // namespace arr
+} // namespace vuh
@@ -6,6 +6,8 @@
 #include "arr/copy_async.hpp"
 #include "arr/deviceArray.hpp"
 #include "arr/hostArray.hpp"
+#include "arr/texelArray.hpp"
+#include "arr/uniformArray.hpp"
 
 namespace vuh {
 namespace detail {
@@ -47,4 +49,12 @@ namespace mem {
 template<class T, class Alloc=arr::AllocDevice<arr::properties::Device>>
 using Array = typename detail::ArrayClass<typename Alloc::properties_t>::template type<T, Alloc>;
 
+/// Read-only array bound to kernels as a uniform buffer.
+template<class T, class Alloc=arr::AllocDevice<arr::properties::Device>>
+using UniformArray = arr::UniformArray<T, Alloc>;
+
+/// Read-only array of formatted elements bound to kernels as a uniform texel buffer.
+template<class T, class Alloc=arr::AllocDevice<arr::properties::Device>>
+using TexelArray = arr::TexelArray<T, Alloc>;
+
 } // namespace vuh
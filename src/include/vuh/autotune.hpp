@@ -0,0 +1,103 @@
+#pragma once
+
+#include "device.h"
+#include "program.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace vuh {
+	namespace detail {
+		// helper
+		template<class Program, class Tuple, size_t... I>
+		auto apply_specs(Program& program, const Tuple& specs, std::index_sequence<I...>)-> void {
+			program.spec(std::get<I>(specs)...);
+		}
+
+		/// Set all specialization constants of the program from the tuple
+		template<class Program, class... Ts>
+		auto apply_specs(Program& program, const std::tuple<Ts...>& specs)-> void {
+			apply_specs(program, specs, std::make_index_sequence<sizeof...(Ts)>{});
+		}
+	} // namespace detail
+
+	/// @return default workgroup size candidates for autotune(), powers of 2 from 32 to 1024
+	/// limited by what the device supports for 1D workgroups.
+	inline auto workgroup_candidates(const vuh::Device& device)-> std::vector<uint32_t> {
+		const auto& limits = device.properties().limits;
+		const auto max_size = std::min(limits.maxComputeWorkGroupSize[0]
+		                               , limits.maxComputeWorkGroupInvocations);
+		auto r = std::vector<uint32_t>{};
+		for(auto s = 32u; s <= std::min(max_size, 1024u); s *= 2){
+			r.push_back(s);
+		}
+		if(r.empty()){
+			r.push_back(max_size);
+		}
+		return r;
+	}
+
+	/// Find the best workgroup size for the 1D kernel running over a given number of elements.
+	/// The workgroup size is the first specialization constant of the program, other constants
+	/// keep their current values.
+	/// Each candidate is run on the given (representative) arguments once to warm up and then
+	/// several times more, the fastest of those runs counts. Runs are timed with GPU timestamps,
+	/// or on the host side if device does not support those.
+	/// The winner is set to the program and stored to the device's tuning database (persisted if
+	/// Device::tuningFile() was set), so programs with the same kernel created on that device later
+	/// pick it up at construction.
+	/// Kernel may modify the arguments, those are left in a state after an unspecified number of runs.
+	/// @return the best workgroup size found
+	template<class Program, class... Args>
+	auto autotune(Program& program              ///< program to tune
+	              , std::size_t n_elements       ///< number of elements, defines the grid size for each candidate
+	              , const std::vector<uint32_t>& candidates ///< workgroup sizes to try
+	              , Args&&... args               ///< push constants (if any) and array arguments to run the program with
+	              )-> uint32_t
+	{
+		constexpr auto n_repeat = 3;
+		using clock = std::chrono::steady_clock;
+		auto& device = program.device();
+		const auto timed = program.timing(true);
+		auto specs = program.specs();
+		auto best = uint32_t(0);
+		auto best_time = std::chrono::nanoseconds::max();
+		for(auto wg: candidates){
+			std::get<0>(specs) = wg;
+			detail::apply_specs(program, specs);
+			program.grid_for(n_elements, wg);
+			program(args...); // warm up, builds the pipeline
+			for(int i = 0; i < n_repeat; ++i){
+				const auto start = clock::now();
+				program(args...);
+				const auto elapsed = timed ? program.last_duration()
+				                           : std::chrono::duration_cast<std::chrono::nanoseconds>(
+				                                                          clock::now() - start);
+				if(elapsed < best_time){
+					best_time = elapsed;
+					best = wg;
+				}
+			}
+		}
+		program.timing(false);
+		std::get<0>(specs) = best;
+		detail::apply_specs(program, specs);
+		program.grid_for(n_elements, best);
+		device.storeTunedWorkgroupSize(program.kernel_hash(), best);
+		return best;
+	}
+
+	/// Find the best workgroup size for the 1D kernel among the default candidates
+	/// (see workgroup_candidates()).
+	template<class Program, class... Args>
+	auto autotune(Program& program, std::size_t n_elements, Args&&... args)-> uint32_t {
+		return autotune(program, n_elements, workgroup_candidates(program.device())
+		                , std::forward<Args>(args)...);
+	}
+} // namespace vuh
@@ -22,8 +22,11 @@ namespace vuh {
 	/// is called (incl. implicitely, ie the object goes out of scope).
 	/// Both wait() function and destructor calls are blocking till the underlying fence
 	/// is signalled.
-	/// If no fence is passed to the contructor of Delayed object the fence in signalled
-	/// state is created under the hood.
+	/// If device supports timeline semaphores the operation is tracked by the point on the queue
+	/// timeline instead of the fence (which is null then). Such operation may also be waited for
+	/// by the other operations on the device, see Program::after().
+	/// If neither fence nor the timeline point is passed to the contructor of Delayed object
+	/// it is created in signalled state.
 	/// The corresponding action will necessarily take place once and only once, whether
 	/// it is at the explicit wait() call or at object destruction.
 	template<class Action=detail::Noop>
@@ -38,9 +41,19 @@ namespace vuh {
 		   , _device(&device)
 		{}
 
-		/// Constructor. Creates the fence in a signalled state.
+		/// Constructor. Takes ownership of the fence of the submission (if any), or tracks
+		/// the submission's point on the queue timeline.
+		Delayed(const Submission& submission, vuh::Device& device, Action action={})
+		   : vk::Fence(submission.fence)
+		   , Action(std::move(action))
+		   , _device(&device)
+		   , _point(submission.point)
+		   , _acquire(submission.acquire)
+		{}
+
+		/// Constructor. Creates the object in a signalled state.
 		explicit Delayed(vuh::Device& device, Action action={})
-		   : vk::Fence(device.createFence({vk::FenceCreateFlagBits::eSignaled}))
+		   : vk::Fence(nullptr)
 		   , Action(std::move(action))
 		   , _device(&device)
 		{}
@@ -50,6 +63,8 @@ namespace vuh {
 		/// Mostly substitute its own action in place of Noop.
 		explicit Delayed(Delayed<detail::Noop>&& noop, Action action={})
 		   : vk::Fence(std::move(noop)), Action(std::move(action)), _device(std::move(noop._device))
+		   , _point(noop._point)
+		   , _acquire(noop._acquire)
 		{}
 
 		/// Destructor. Blocks till the undelying fence is signalled (waits forever).
@@ -69,13 +84,35 @@ namespace vuh {
 			static_cast<vk::Fence&>(*this) = std::move(static_cast<vk::Fence&>(other));
 			static_cast<Action&>(*this) = std::move(static_cast<Action&>(other));
 			_device = std::move(other._device);
+			_point = other._point;
+			_acquire = other._acquire;
 			return *this;
 		}
 
+		/// @return point on the queue timeline the operation signals on completion,
+		/// null semaphore if the operation is tracked by the fence.
+		auto point() const-> const TimelinePoint& { return _point; }
+
+		/// Hand over the barrier acquiring the buffer range written by the operation for
+		/// the compute queue family. The operation has released the range from its queue family
+		/// (see Device::releaseToCompute()), the barrier should be recorded once by the compute
+		/// queue before the range is used there.
+		/// @return the barrier, null buffer if no ownership transfer is needed or the barrier
+		/// was already handed over
+		auto acquire_barrier()-> vk::BufferMemoryBarrier {
+			const auto r = _acquire;
+			_acquire = vk::BufferMemoryBarrier{};
+			return r;
+		}
+
+		/// @return the barrier acquire_barrier() would hand over, without taking it
+		auto pending_acquire() const-> const vk::BufferMemoryBarrier& { return _acquire; }
+
 		/// Blocks execution of the current thread till the underlying fence is signalled or
 		/// given time period has elapsed.
 		/// If the fence was signalled - triggers the Action and releases vulkan resources
-		/// associated with the object (not waiting for destructor actually).
+		/// associated with the object (not waiting for destructor actually). The fence goes back
+		/// to the device for reuse (see Device::acquireFence()).
 		/// If exits by the timer event - no action is taken.
 		/// All is postponed till another wait() call or destructor.
 		/// The function can be safely called arbitrary number of times.
@@ -83,17 +120,31 @@ namespace vuh {
 		auto wait(size_t period=size_t(-1) ///< time period (nanoseconds) to wait for the fence to be signalled.
 		         ) noexcept-> void
 		{
-			if(_device){
-				_device->waitForFences({*this}, true, period);
-				if(_device->getFenceStatus(*this) == vk::Result::eSuccess){
-					_device->destroyFence(*this);
-					static_cast<Action&>(*this)(); // exercise action
-					_device.release();
+			if(_device && signalled(period)){
+				if(static_cast<vk::Fence&>(*this)){
+					_device->recycleFence(*this);
 				}
+				static_cast<Action&>(*this)(); // exercise action
+				_device.release();
+			}
+		}
+	private: // helpers
+		/// Wait for the timeline point or the fence for a given time period (nanoseconds).
+		/// @return true if the operation is complete
+		auto signalled(size_t period) noexcept-> bool {
+			if(_point.semaphore){
+				return _device->waitTimeline(_point, period);
+			}
+			if(!static_cast<vk::Fence&>(*this)){
+				return true;
 			}
+			_device->waitForFences({*this}, true, period);
+			return _device->getFenceStatus(*this) == vk::Result::eSuccess;
 		}
 	private: // data
 		std::unique_ptr<Device, util::NoopDeleter<Device>> _device; ///< refers to the device owning corresponding the underlying fence.
+		TimelinePoint _point; ///< point on the queue timeline signalled on completion, null semaphore if the fence is used
+		vk::BufferMemoryBarrier _acquire; ///< barrier acquiring the range released by the operation for the compute queue family, null buffer if there is none
 	}; // class Delayed
 
 	/// Delayed No-Action. Just a synchronization point.
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <vuh/device.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace vuh {
+namespace detail {
+	/// Growable collection of descriptor sets sharing the same layout.
+	/// Sets are handed out one at a time and marked busy till explicitly freed, which normally
+	/// happens when the async operation using the set completes.
+	/// This allows several invocations of the same program with different arguments to be in flight
+	/// at the same time without one overwriting the descriptor set the other is still using.
+	/// Sets are allocated in chunks, each chunk from its own pool. When all sets are busy a new chunk
+	/// is allocated.
+	/// Acquiring sets is not thread-safe, while freeing them is (so the set may be freed by the
+	/// thread waiting for the async operation to complete).
+	/// If the layout ends with a variable-sized (descriptor indexing) binding, the sets are allocated
+	/// with the given number of descriptors in that binding from update-after-bind pools.
+	class DescriptorRing {
+	public:
+		static constexpr uint32_t chunk_size = 8;         ///< number of sets allocated at once
+		static constexpr uint32_t no_slot = uint32_t(-1); ///< denotes invalid slot id
+
+		/// Constructs empty ring. No sets can be acquired from that.
+		DescriptorRing() = default;
+
+		/// Constructor. Sets will be allocated with the given layout.
+		/// Pool sizes are those required for a single set.
+		/// Non-zero variable count is the number of descriptors in the variable-sized last binding
+		/// of the layout.
+		DescriptorRing(vuh::Device& device, vk::DescriptorSetLayout layout
+		               , std::vector<vk::DescriptorPoolSize> set_sizes
+		               , uint32_t variable_count=0
+		               )
+		   : _device(&device), _layout(layout), _set_sizes(std::move(set_sizes))
+		   , _variable_count(variable_count)
+		{}
+
+		/// Destroy all pools and sets allocated from those.
+		~DescriptorRing() noexcept { release(); }
+
+		DescriptorRing(const DescriptorRing&) = delete;
+		auto operator= (const DescriptorRing&)-> DescriptorRing& = delete;
+
+		/// Move constructor.
+		DescriptorRing(DescriptorRing&& o) noexcept
+		   : _device(o._device)
+		   , _layout(o._layout)
+		   , _set_sizes(std::move(o._set_sizes))
+		   , _variable_count(o._variable_count)
+		   , _chunks(std::move(o._chunks))
+		{
+			o._chunks.clear();
+		}
+
+		/// Move assignment. Releases own resources before taking over those of the other object.
+		auto operator= (DescriptorRing&& o) noexcept-> DescriptorRing& {
+			release();
+			_device = o._device;
+			_layout = o._layout;
+			_set_sizes = std::move(o._set_sizes);
+			_variable_count = o._variable_count;
+			_chunks = std::move(o._chunks);
+			o._chunks.clear();
+			return *this;
+		}
+
+		/// Find the free descriptor set and mark it busy. Allocates a new chunk of sets if all are busy.
+		/// @return id of the acquired set
+		auto acquire()-> uint32_t {
+			assert(_device);
+			for(uint32_t i = 0; i < uint32_t(_chunks.size()); ++i){
+				for(uint32_t j = 0; j < chunk_size; ++j){
+					auto& busy = _chunks[i].busy[j];
+					if(!busy.load(std::memory_order_acquire)){
+						busy.store(true, std::memory_order_relaxed);
+						return i*chunk_size + j;
+					}
+				}
+			}
+			add_chunk();
+			_chunks.back().busy[0].store(true, std::memory_order_relaxed);
+			return uint32_t(_chunks.size() - 1)*chunk_size;
+		}
+
+		/// @return descriptor set with a given id
+		auto set(uint32_t id) const-> vk::DescriptorSet {
+			return _chunks[id/chunk_size].sets[id%chunk_size];
+		}
+
+		/// @return the busy flag of a set with a given id.
+		/// Storing false to that frees the set. The flag location is stable for the whole lifetime
+		/// of the ring (and is not affected by the move of the ring object).
+		auto busy_flag(uint32_t id)-> std::atomic<bool>* {
+			return &_chunks[id/chunk_size].busy[id%chunk_size];
+		}
+
+		/// @return the record of what was last written to the set with a given id.
+		/// The ring does not interpret this, it is up to the user to keep it in sync with the
+		/// actual set content (to skip the redundant descriptor updates).
+		auto contents(uint32_t id)-> std::vector<char>& {
+			return _chunks[id/chunk_size].contents[id%chunk_size];
+		}
+
+		/// @return total number of allocated descriptor sets
+		auto capacity() const-> std::size_t { return _chunks.size()*chunk_size; }
+	private: // helpers
+		/// Chunk of descriptor sets allocated from a single pool.
+		struct Chunk {
+			vk::DescriptorPool pool;                                ///< pool sets are allocated from
+			std::array<vk::DescriptorSet, chunk_size> sets;         ///< descriptor sets
+			std::unique_ptr<std::atomic<bool>[]> busy;              ///< in-use flags of the sets
+			std::array<std::vector<char>, chunk_size> contents;     ///< records of the sets content
+		};
+
+		/// Allocate a new chunk of sets.
+		auto add_chunk()-> void {
+			auto sizes = _set_sizes;
+			for(auto& s: sizes){
+				s.descriptorCount *= chunk_size;
+			}
+			const auto pool_flags = _variable_count > 0
+			                        ? vk::DescriptorPoolCreateFlags(
+			                               vk::DescriptorPoolCreateFlagBits::eUpdateAfterBindEXT)
+			                        : vk::DescriptorPoolCreateFlags();
+			auto chunk = Chunk{};
+			chunk.pool = _device->createDescriptorPool({pool_flags, chunk_size
+			                                           , uint32_t(sizes.size()), sizes.data()});
+			auto layouts = std::array<vk::DescriptorSetLayout, chunk_size>{};
+			layouts.fill(_layout);
+			auto counts = std::array<uint32_t, chunk_size>{};
+			counts.fill(_variable_count);
+			auto countsAI = vk::DescriptorSetVariableDescriptorCountAllocateInfoEXT(chunk_size
+			                                                                       , counts.data());
+			auto setsAI = vk::DescriptorSetAllocateInfo(chunk.pool, chunk_size, layouts.data());
+			if(_variable_count > 0){
+				setsAI.pNext = &countsAI;
+			}
+			auto sets = _device->allocateDescriptorSets(setsAI);
+			std::copy(sets.begin(), sets.end(), chunk.sets.begin());
+			chunk.busy.reset(new std::atomic<bool>[chunk_size]);
+			for(uint32_t i = 0; i < chunk_size; ++i){
+				chunk.busy[i].store(false, std::memory_order_relaxed);
+			}
+			_chunks.push_back(std::move(chunk));
+		}
+
+		/// Release pools (and with those all descriptor sets).
+		auto release() noexcept-> void {
+			for(auto& c: _chunks){
+				_device->destroyDescriptorPool(c.pool);
+			}
+			_chunks.clear();
+		}
+	private: // data
+		vuh::Device* _device = nullptr;                 ///< device sets are allocated on
+		vk::DescriptorSetLayout _layout;                ///< layout of all sets in the ring
+		std::vector<vk::DescriptorPoolSize> _set_sizes; ///< number of descriptors of each type in a single set
+		uint32_t _variable_count = 0;                   ///< number of descriptors in the variable-sized binding, 0 if there is none
+		std::vector<Chunk> _chunks;                     ///< allocated chunks of sets
+	}; // class DescriptorRing
+} // namespace detail
+} // namespace vuh
@@ -2,11 +2,136 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace vuh {
 	class Instance;
 
+	/// Optional device features vuh knows how to make use of.
+	/// Those are enabled at device creation whenever supported by the physical device.
+	struct DeviceFeatures {
+		/// Runtime-sized, partially bound, update-after-bind arrays of storage buffer descriptors
+		/// (VK_EXT_descriptor_indexing).
+		bool descriptor_indexing = false;
+		/// Max number of storage buffers in the update-after-bind descriptor array.
+		uint32_t max_update_after_bind_buffers = 0;
+		/// Buffers can be created with eShaderDeviceAddress usage and queried for their device
+		/// addresses (VK_KHR_buffer_device_address).
+		bool buffer_device_address = false;
+		/// Number of invocations in a subgroup (Vulkan 1.1), 1 if the device does not report it.
+		uint32_t subgroup_size = 1;
+		/// Subgroup operations supported in compute kernels, empty if the device does not report
+		/// those (Vulkan 1.0).
+		vk::SubgroupFeatureFlags subgroup_operations;
+		/// Kernels can be built for a required subgroup size (VK_EXT_subgroup_size_control).
+		bool subgroup_size_control = false;
+		/// Min subgroup size a kernel can require, 0 without subgroup size control.
+		uint32_t min_subgroup_size = 0;
+		/// Max subgroup size a kernel can require, 0 without subgroup size control.
+		uint32_t max_subgroup_size = 0;
+		/// Max number of subgroups in a workgroup of a kernel with the required subgroup size,
+		/// 0 without subgroup size control.
+		uint32_t max_workgroup_subgroups = 0;
+		/// Async operations are tracked with the queue timeline semaphores and may wait for each
+		/// other on the device (VK_KHR_timeline_semaphore, core in Vulkan 1.2).
+		bool timeline_semaphore = false;
+	};
+
+	/// How the buffers are shared between the compute and transfer queue families (when those
+	/// are different).
+	enum class QueueSharing {
+		Concurrent, ///< buffers are accessed by both families concurrently, no ownership transfers
+		Exclusive   ///< buffers are owned by one family at a time, async copies to device arrays release the range to the compute family, so each of those should be chained to a kernel
+	};
+
+	/// Point on the queue timeline, that is the value the queue's timeline semaphore reaches
+	/// when the async operation submitted to the queue completes.
+	struct TimelinePoint {
+		vk::Semaphore semaphore; ///< timeline semaphore of the queue, null if operation is not on the timeline
+		uint64_t value = 0;      ///< semaphore value signalled when the operation completes
+	};
+
+	/// Handle to synchronize with the submitted async operation.
+	/// Operation signals the point on the queue timeline if device supports timeline semaphores,
+	/// the fence otherwise.
+	struct Submission {
+		vk::Fence fence;     ///< fence signalled on completion, null if the timeline is used
+		TimelinePoint point; ///< point on the queue timeline, null semaphore if the fence is used
+		vk::BufferMemoryBarrier acquire; ///< barrier acquiring the buffer range released by the operation for the compute queue family, null buffer if there is none
+	};
+
+	/// Usage counters of the list of device objects kept for reuse.
+	struct PoolCounters {
+		std::size_t hits = 0;   ///< number of objects handed out from the list
+		std::size_t misses = 0; ///< number of objects created because the list was empty
+		std::size_t size = 0;   ///< number of objects currently in the list
+
+		/// @return share of the objects handed out from the list, 0 if none were handed out yet
+		auto hitRate() const-> double {
+			return hits + misses == 0 ? 0. : double(hits)/double(hits + misses);
+		}
+	};
+
+	/// Usage counters of the device's recycling pools (see Device::poolStats()).
+	struct PoolStats {
+		PoolCounters fences;           ///< fences used to sync with the async operations
+		PoolCounters compute_buffers;  ///< command buffers of the compute queue family
+		PoolCounters transfer_buffers; ///< command buffers of the transfer queue family, empty if it is the compute one
+		PoolCounters semaphores;       ///< binary semaphores chaining the operations on the device
+	};
+
+	namespace detail {
+		/// List of device objects of one kind kept for reuse, with its usage counters.
+		template<class Handle>
+		struct RecycledList {
+			std::vector<Handle> objects; ///< objects ready for reuse
+			std::size_t hits = 0;        ///< number of objects taken from the list
+			std::size_t misses = 0;      ///< number of times the list was empty when asked for an object
+
+			/// Take the object from the list.
+			/// @return the object, or the null handle if the list is empty
+			auto take()-> Handle {
+				if(objects.empty()){
+					++misses;
+					return Handle{};
+				}
+				++hits;
+				const auto r = objects.back();
+				objects.pop_back();
+				return r;
+			}
+
+			/// @return usage counters of the list
+			auto counters() const-> PoolCounters {
+				auto r = PoolCounters{};
+				r.hits = hits;
+				r.misses = misses;
+				r.size = objects.size();
+				return r;
+			}
+		};
+
+		/// Device objects handed out to the async operations and taken back when those complete,
+		/// so that the steady stream of operations does not create and destroy driver objects.
+		/// Objects may be taken back on any thread.
+		struct Recycled {
+			std::mutex mutex;                                ///< guards the lists
+			RecycledList<vk::Fence> fences;                  ///< fences in unsignalled state
+			RecycledList<vk::CommandBuffer> compute_buffers; ///< command buffers of the compute pool
+			RecycledList<vk::CommandBuffer> transfer_buffers; ///< command buffers of the transfer pool (if it is not the compute one)
+			RecycledList<vk::Semaphore> semaphores;          ///< unsignalled binary semaphores with no pending waits
+		};
+	} // namespace detail
+
 	/// Logical device packed with associated command pools and buffers.
 	/// Holds the pool(s) for transfer and compute operations as well as command
 	/// buffers for sync operations.
@@ -27,29 +152,94 @@ namespace vuh {
 		auto operator=(Device&&) noexcept-> Device&;
 		friend auto swap(Device& d1, Device& d2)-> void;
 
-		auto properties() const-> vk::PhysicalDeviceProperties;
+		auto properties() const-> const vk::PhysicalDeviceProperties& { return _properties; }
 		auto numComputeQueues() const-> uint32_t { return 1u;}
 		auto numTransferQueues() const-> uint32_t { return 1u;}
 		auto memoryProperties(uint32_t id) const-> vk::MemoryPropertyFlags;
+		auto formatProperties(vk::Format format) const-> vk::FormatProperties;
 		auto selectMemory(vk::Buffer buffer, vk::MemoryPropertyFlags properties) const-> uint32_t;
+		auto selectMemory(vk::Image image, vk::MemoryPropertyFlags properties) const-> uint32_t;
 		auto instance() const-> const vuh::Instance& {return _instance;}
 		auto hasSeparateQueues() const-> bool;
+		auto computeFamilyId() const-> uint32_t { return _cmp_family_id; }
+		auto transferFamilyId() const-> uint32_t { return _tfr_family_id; }
+		auto apiVersion() const-> uint32_t;
 
 		auto computeQueue(uint32_t i = 0)-> vk::Queue;
 		auto transferQueue(uint32_t i = 0)-> vk::Queue;
 		auto alloc(vk::Buffer buf, uint32_t memory_id)-> vk::DeviceMemory;
 		auto computeCmdPool()-> vk::CommandPool {return _cmdpool_compute;}
 		auto computeCmdBuffer()-> vk::CommandBuffer& {return _cmdbuf_compute;}
+		auto beginComputeCmdBuffer(vk::CommandBufferUsageFlags flags={})-> vk::CommandBuffer;
+		auto recordedComputeCmdBuffer() const-> vk::CommandBuffer {return _cmdbuf_compute;}
+		auto computeCmdBufferVersion() const-> uint64_t {return _cmdbuf_compute_version;}
 		auto transferCmdPool()-> vk::CommandPool;
 		auto transferCmdBuffer()-> vk::CommandBuffer&;
+		auto beginTransferCmdBuffer(vk::CommandBufferUsageFlags flags={})-> vk::CommandBuffer;
 		auto createPipeline(vk::PipelineLayout pipe_layout
 		                    , vk::PipelineCache pipe_cache
 		                    , const vk::PipelineShaderStageCreateInfo& shader_stage_info
 		                    , vk::PipelineCreateFlags flags={}
+		                    , vk::Pipeline base_pipeline={}
 		                    )-> vk::Pipeline;
 		auto instance()-> vuh::Instance& { return _instance; }
 		auto releaseComputeCmdBuffer()-> vk::CommandBuffer;
-		
+		auto acquireComputeCmdBuffer()-> vk::CommandBuffer;
+		auto recycleComputeCmdBuffer(vk::CommandBuffer buffer) noexcept-> void;
+		auto acquireTransferCmdBuffer()-> vk::CommandBuffer;
+		auto recycleTransferCmdBuffer(vk::CommandBuffer buffer) noexcept-> void;
+		auto acquireFence()-> vk::Fence;
+		auto recycleFence(vk::Fence fence) noexcept-> void;
+		auto acquireSemaphore()-> vk::Semaphore;
+		auto recycleSemaphore(vk::Semaphore semaphore) noexcept-> void;
+		auto poolStats() const-> PoolStats;
+		auto syncSpin() const-> std::chrono::nanoseconds { return _sync_spin; }
+		auto syncSpin(std::chrono::nanoseconds period)-> void { _sync_spin = period; }
+		auto waitFence(vk::Fence fence, std::chrono::nanoseconds spin) const-> void;
+		auto submitSync(vk::Queue queue, vk::CommandBuffer cmd_buf, std::chrono::nanoseconds spin
+		                , const TimelinePoint* waits=nullptr, uint32_t n_waits=0)-> void;
+		auto submitComputeAsync(vk::CommandBuffer cmd_buf
+		                        , const TimelinePoint* waits=nullptr, uint32_t n_waits=0)-> Submission;
+		auto submitTransferAsync(vk::CommandBuffer cmd_buf
+		                         , const TimelinePoint* waits=nullptr, uint32_t n_waits=0)-> Submission;
+		auto waitTimeline(const TimelinePoint& point, uint64_t timeout) const noexcept-> bool;
+		auto queueSharing() const-> QueueSharing { return _queue_sharing; }
+		auto queueSharing(QueueSharing sharing)-> void { _queue_sharing = sharing; }
+		auto makeBuffer(vk::DeviceSize size_bytes, vk::BufferUsageFlags usage)-> vk::Buffer;
+		auto releaseToCompute(vk::CommandBuffer cmd_buf, vk::Buffer buffer
+		                      , vk::DeviceSize offset, vk::DeviceSize size)-> vk::BufferMemoryBarrier;
+
+		auto hasExtension(const char* name) const-> bool;
+		auto features() const-> const DeviceFeatures& { return _features; }
+		auto bufferDeviceAddress(vk::Buffer buffer) const-> uint64_t;
+		auto supportsPushDescriptors() const-> bool { return _push_descriptor_fn != nullptr; }
+		auto cmdPushDescriptorSet(vk::CommandBuffer cmd_buffer, vk::PipelineLayout layout
+		                          , uint32_t n_writes, const vk::WriteDescriptorSet* writes
+		                          ) const-> void;
+		auto supportsDispatchBase() const-> bool { return _dispatch_base_fn != nullptr; }
+		auto cmdDispatchBase(vk::CommandBuffer cmd_buffer, const std::array<uint32_t, 3>& base
+		                     , const std::array<uint32_t, 3>& count
+		                     ) const-> void;
+
+		auto pipelineCache()-> vk::PipelineCache { return _pipecache; }
+		auto pipelineCacheFile(const std::string& filepath)-> bool;
+		auto savePipelineCache()-> void;
+
+		auto timestampValidBits() const-> uint32_t { return _timestamp_bits; }
+		auto tuningFile(const std::string& filepath)-> bool;
+		auto tunedWorkgroupSize(uint64_t kernel_hash) const-> uint32_t;
+		auto storeTunedWorkgroupSize(uint64_t kernel_hash, uint32_t workgroup_size)-> void;
+
+		auto sharedShaderModule(const uint32_t* code, std::size_t size_bytes
+		                        , vk::ShaderModuleCreateFlags flags={})-> vk::ShaderModule;
+		auto sharedDescriptorSetLayout(const std::string& key, const vk::DescriptorSetLayoutCreateInfo& info
+		                               )-> vk::DescriptorSetLayout;
+		auto sharedPipelineLayout(const std::string& key, const vk::PipelineLayoutCreateInfo& info
+		                          )-> vk::PipelineLayout;
+		auto releaseShared(vk::ShaderModule module) noexcept-> void;
+		auto releaseShared(vk::DescriptorSetLayout layout) noexcept-> void;
+		auto releaseShared(vk::PipelineLayout layout) noexcept-> void;
+
 	private: // helpers
 		explicit Device(vuh::Instance& instance, vk::PhysicalDevice physDevice
 		                , const std::vector<vk::QueueFamilyProperties>& families
@@ -58,14 +248,53 @@ namespace vuh {
 	                   , uint32_t computeFamilyId, uint32_t transferFamilyId
 					   , const std::vector<const char*>& extensions={});
 		auto release() noexcept-> void;
+		auto submitAsync(vk::Queue queue, vk::Semaphore timeline, uint64_t& timeline_value
+		                 , vk::CommandBuffer cmd_buf, const TimelinePoint* waits, uint32_t n_waits
+		                 )-> Submission;
+		auto mergePipelineCache(const std::vector<uint8_t>& data)-> void;
 	private: // data
+		/// Object shared between programs with the bytes of its content and the number of its users.
+		template<class Handle>
+		struct SharedObject {
+			Handle handle;
+			std::string key;    ///< content bytes, tell apart the objects with the same hash
+			uint32_t users = 0;
+		};
+
+		/// Objects shared between programs keyed by the hash of their content.
+		template<class Handle>
+		using Shared = std::multimap<uint64_t, SharedObject<Handle>>;
+
 		const std::vector<const char*> _extensions; ///< enabled extensions
 		vuh::Instance&     _instance;           ///< refer to Instance object used to create device
 		vk::PhysicalDevice _physdev;            ///< handle to associated physical device
+		vk::PhysicalDeviceProperties _properties; ///< cached physical device properties (incl. limits)
+		DeviceFeatures     _features;           ///< optional features enabled on the device
 		vk::CommandPool    _cmdpool_compute;    ///< handle to command pool for compute commands
 		vk::CommandBuffer  _cmdbuf_compute;     ///< primary command buffer associated with the compute command pool
+		uint64_t _cmdbuf_compute_version = 0;   ///< bumped whenever the compute command buffer is re-recorded or replaced
 		vk::CommandPool    _cmdpool_transfer;   ///< handle to command pool for transfer instructions. Initialized on first trasnfer request.
 		vk::CommandBuffer  _cmdbuf_transfer;    ///< primary command buffer associated with transfer command pool. Initialized on first transfer request.
+		vk::PipelineCache  _pipecache;          ///< pipeline cache shared by all programs created on this device
+		std::string _pipecache_path;            ///< file the pipeline cache is persisted to. Empty if cache is not persistent.
+		std::map<uint64_t, uint32_t> _tuning;   ///< tuned workgroup sizes of the kernels (keyed by SPIR-V code hash) on this device
+		std::string _tuning_path;               ///< file the tuned workgroup sizes are persisted to. Empty if those are not persistent.
+		Shared<vk::ShaderModule> _shared_modules;         ///< shader modules shared by programs with the same code
+		Shared<vk::DescriptorSetLayout> _shared_dsclayouts; ///< descriptor set layouts shared by programs with the same array parameters
+		Shared<vk::PipelineLayout> _shared_pipelayouts;   ///< pipeline layouts shared by programs with the same interface
+		std::unique_ptr<std::mutex> _shared_mutex;        ///< guards the shared objects registries above
+		std::unique_ptr<detail::Recycled> _recycled;      ///< fences, command buffers and semaphores kept for reuse
+		std::chrono::nanoseconds _sync_spin{0}; ///< time sync operations poll their fence for before blocking on it
+		vk::Semaphore _timeline_compute;        ///< timeline semaphore of the compute queue, null if timelines are not supported
+		uint64_t _timeline_compute_value = 0;   ///< last value submitted to be signalled on the compute queue timeline
+		vk::Semaphore _timeline_transfer;       ///< timeline semaphore of the transfer queue, null if it is the compute queue or timelines are not supported
+		uint64_t _timeline_transfer_value = 0;  ///< last value submitted to be signalled on the transfer queue timeline
+		QueueSharing _queue_sharing = QueueSharing::Concurrent; ///< sharing mode of the buffers created from now on
+		uint32_t _timestamp_bits = 0;           ///< number of valid bits in timestamps written to compute queue, 0 if timestamps are not supported
+		PFN_vkCmdPushDescriptorSetKHR _push_descriptor_fn = nullptr; ///< vkCmdPushDescriptorSetKHR if VK_KHR_push_descriptor is enabled, nullptr otherwise
+		PFN_vkGetBufferDeviceAddressKHR _buffer_address_fn = nullptr; ///< vkGetBufferDeviceAddressKHR if buffer device address feature is enabled, nullptr otherwise
+		PFN_vkCmdDispatchBaseKHR _dispatch_base_fn = nullptr; ///< vkCmdDispatchBaseKHR if VK_KHR_device_group is enabled, nullptr otherwise
+		PFN_vkWaitSemaphoresKHR _wait_semaphores_fn = nullptr; ///< vkWaitSemaphoresKHR if timeline semaphores are enabled, nullptr otherwise
 		uint32_t _cmp_family_id = uint32_t(-1); ///< compute queue family id. -1 if device does not have compute-capable queues.
 		uint32_t _tfr_family_id = uint32_t(-1); ///< transfer queue family id, maybe the same as compute queue id.
 	}; // class Device
@@ -18,6 +18,13 @@ namespace vuh {
 		FileReadFailure(const char* message);
 	};
 
+	/// Exception indicating failure to write a file.
+	class FileWriteFailure: public std::runtime_error {
+	public:
+		FileWriteFailure(const std::string& message);
+		FileWriteFailure(const char* message);
+	};
+
 	// Exception indicating a mandatory requested layer was not found
 	class LayerNotFound: public std::runtime_error {
 	public:
@@ -31,4 +38,18 @@ namespace vuh {
 		ExtensionNotFound(const std::string& message);
 		ExtensionNotFound(const char* message);
 	};
+
+	/// Exception indicating the format is not supported by a device for the requested usage.
+	class FormatNotSupported: public std::runtime_error {
+	public:
+		FormatNotSupported(const std::string& message);
+		FormatNotSupported(const char* message);
+	};
+
+	/// Exception indicating failure to compile the kernel source code.
+	class CompilationFailure: public std::runtime_error {
+	public:
+		CompilationFailure(const std::string& message);
+		CompilationFailure(const char* message);
+	};
 } // namespace vuh
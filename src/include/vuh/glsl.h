@@ -0,0 +1,20 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vuh {
+	/// Preprocessor definitions (name, value) the GLSL source is compiled with.
+	using GlslDefines = std::vector<std::pair<std::string, std::string>>;
+
+	auto glsl_supported()-> bool;
+	auto glsl_cache_path(const std::string& source, const GlslDefines& defines
+	                     , const std::string& cache_dir, uint32_t api_version=VK_API_VERSION_1_0
+	                     )-> std::string;
+	auto compile_glsl(const std::string& source, const GlslDefines& defines={}
+	                  , const std::string& cache_dir={}, uint32_t api_version=VK_API_VERSION_1_0
+	                  )-> std::vector<char>;
+} // namespace vuh
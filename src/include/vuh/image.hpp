@@ -0,0 +1,17 @@
+#pragma once
+
+#include "img/basicImage.hpp"
+#include "img/copy_async.hpp"
+#include "img/sampledImage.hpp"
+
+namespace vuh {
+
+/// 2D image in device-local memory with optimal tiling, T is the host-side pixel type.
+template<class T>
+using Image2D = img::BasicImage<T, 2>;
+
+/// 3D image in device-local memory with optimal tiling, T is the host-side pixel type.
+template<class T>
+using Image3D = img::BasicImage<T, 3>;
+
+} // namespace vuh
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "imageUtils.h"
+
+#include <vuh/arr/hostArray.hpp>
+#include <vuh/arr/allocDevice.hpp>
+#include <vuh/device.h>
+#include <vuh/error.h>
+#include <vuh/instance.h>
+#include <vuh/utils.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <string>
+
+namespace vuh {
+namespace img {
+
+/// Traits to map pixel types to default image formats.
+/// Formats of other pixel types should be given explicitly at image construction.
+template<class T> struct DefaultFormat { static constexpr auto value = vk::Format::eUndefined; };
+template<> struct DefaultFormat<float> { static constexpr auto value = vk::Format::eR32Sfloat; };
+template<> struct DefaultFormat<int32_t> { static constexpr auto value = vk::Format::eR32Sint; };
+template<> struct DefaultFormat<uint32_t> { static constexpr auto value = vk::Format::eR32Uint; };
+template<> struct DefaultFormat<std::array<float, 4>> {
+	static constexpr auto value = vk::Format::eR32G32B32A32Sfloat;
+};
+template<> struct DefaultFormat<std::array<uint8_t, 4>> {
+	static constexpr auto value = vk::Format::eR8G8B8A8Unorm;
+};
+
+/// 2D or 3D image in device-local memory with optimal tiling.
+/// Unlike the arrays, the layout of image data in memory is up to the implementation
+/// (usually tiled for 2D/3D locality), which pays off for kernels accessing the neighbourhoods
+/// of pixels/voxels.
+/// Image is kept in general layout for its whole lifetime, so it can be bound to kernels
+/// as a storage image as well as sampled (see SampledImage), and transferred to/from host
+/// with no explicit layout transitions.
+/// Data exchange with host goes through the staging buffers, host data is tightly packed with
+/// x index running fastest.
+/// Type T is the host-side type of a single pixel, its size should match the format texel size.
+template<class T, uint32_t Dim>
+class BasicImage: public vk::Image {
+	static_assert(Dim == 2 || Dim == 3, "only 2D and 3D images are supported");
+	using StageToDevice = arr::HostArray<T, arr::AllocDevice<arr::properties::HostCoherent>>;
+	using StageToHost = arr::HostArray<T, arr::AllocDevice<arr::properties::HostCached>>;
+public:
+	using value_type = T;
+	static constexpr auto descriptor_class = vk::DescriptorType::eStorageImage;
+
+	/// Construct image of given dimensions. Content is uninitialized.
+	/// Usage flags are derived from what the format supports with optimal tiling (storage,
+	/// sampled, transfer).
+	/// @throws vuh::FormatNotSupported if format can be neither used for storage nor
+	/// for sampled images.
+	BasicImage(vuh::Device& device     ///< device to create image on
+	           , uint32_t width        ///< image width (pixels)
+	           , uint32_t height       ///< image height (pixels)
+	           , uint32_t depth=1      ///< image depth (pixels), should be 1 for 2D images
+	           , vk::Format format=DefaultFormat<T>::value ///< pixel format
+	           )
+	   : vk::Image(createImage(device, {width, height, depth}, format))
+	   , _dev(&device)
+	   , _id(unique_id())
+	   , _extent{width, height, depth}
+	   , _format(format)
+	{
+		try {
+			auto memid = device.selectMemory(*this, vk::MemoryPropertyFlagBits::eDeviceLocal);
+			if(memid == uint32_t(-1)){
+				device.instance().report("BasicImage could not find device-local memory, using fallback"
+				                         , " ", VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT);
+				memid = device.selectMemory(*this, vk::MemoryPropertyFlags{});
+			}
+			if(memid == uint32_t(-1)){
+				throw NoSuitableMemoryFound("no memory suitable for the image could be found");
+			}
+			_mem = device.allocateMemory({device.getImageMemoryRequirements(*this).size, memid});
+			device.bindImageMemory(*this, _mem, 0);
+			const auto viewType = Dim == 2 ? vk::ImageViewType::e2D : vk::ImageViewType::e3D;
+			_view = device.createImageView({vk::ImageViewCreateFlags(), *this, viewType, format
+			                                , vk::ComponentMapping{}
+			                                , {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1}});
+			initLayout(device, *this);
+		} catch(std::runtime_error&){ // destroy what was created if image initialization was not successful
+			release();
+			throw;
+		}
+	}
+
+	/// Release resources associated with current object.
+	~BasicImage() noexcept { release(); }
+
+	BasicImage(const BasicImage&) = delete;
+	BasicImage& operator= (const BasicImage&) = delete;
+
+	/// Move constructor. Passes the underlying image ownership.
+	BasicImage(BasicImage&& o) noexcept
+	   : vk::Image(o), _mem(o._mem), _view(o._view), _dev(o._dev), _id(o._id), _extent(o._extent), _format(o._format)
+	{
+		static_cast<vk::Image&>(o) = nullptr;
+	}
+
+	/// Move assignment. Resources associated with current image are released immidiately.
+	auto operator= (BasicImage&& o) noexcept-> BasicImage& {
+		release();
+		static_cast<vk::Image&>(*this) = static_cast<vk::Image&>(o);
+		_mem = o._mem;
+		_view = o._view;
+		_dev = o._dev;
+		_id = o._id;
+		_extent = o._extent;
+		_format = o._format;
+		static_cast<vk::Image&>(o) = nullptr;
+		return *this;
+	}
+
+	/// Copy data from host range to the image. Range should cover the whole image.
+	template<class It1, class It2>
+	auto fromHost(It1 begin, It2 end)-> void {
+		assert(size_t(std::distance(begin, end)) == size());
+		auto stage = StageToDevice(*_dev, begin, end);
+		copyBufToImage(*_dev, stage, *this, _extent);
+	}
+
+	/// Copy the whole image data to host location indicated by iterator.
+	template<class It>
+	auto toHost(It copy_to) const-> void {
+		using std::begin; using std::end;
+		auto stage = StageToHost(*_dev, size());
+		copyImageToBuf(*_dev, *this, stage, _extent);
+		std::copy(begin(stage), end(stage), copy_to);
+	}
+
+	/// @return host container with a copy of image data.
+	template<class C>
+	auto toHost() const-> C {
+		auto ret = C(size());
+		using std::begin;
+		toHost(begin(ret));
+		return ret;
+	}
+
+	/// @return view of the whole image
+	auto view() const-> vk::ImageView { return _view; }
+
+	/// @return descriptor info to bind image as a storage image
+	auto image_info() const-> vk::DescriptorImageInfo {
+		return {vk::Sampler{}, _view, vk::ImageLayout::eGeneral};
+	}
+
+	/// @return image dimensions (pixels)
+	auto extent() const-> vk::Extent3D { return _extent; }
+	auto width() const-> uint32_t { return _extent.width; }
+	auto height() const-> uint32_t { return _extent.height; }
+	auto depth() const-> uint32_t { return _extent.depth; }
+
+	/// @return number of pixels
+	auto size() const-> size_t { return size_t(_extent.width)*_extent.height*_extent.depth; }
+
+	/// @return size of the (tightly packed) image data in bytes
+	auto size_bytes() const-> size_t { return size()*sizeof(T); }
+
+	/// @return pixel format
+	auto format() const-> vk::Format { return _format; }
+
+	/// @return reference to device on which underlying image is allocated
+	auto device()-> vuh::Device& { return *_dev; }
+
+	/// @return id of the image. Unlike the image handle it is never reused by the other images.
+	auto id() const-> uint64_t { return _id; }
+private: // helpers
+	/// @return image handle created with the usage flags supported by the format
+	/// @throws vuh::FormatNotSupported
+	static auto createImage(vuh::Device& device, vk::Extent3D extent, vk::Format format)-> vk::Image {
+		assert(Dim == 3 || extent.depth == 1);
+		const auto features = device.formatProperties(format).optimalTilingFeatures;
+		auto usage = vk::ImageUsageFlags(vk::ImageUsageFlagBits::eTransferSrc)
+		             | vk::ImageUsageFlagBits::eTransferDst;
+		if(features & vk::FormatFeatureFlagBits::eStorageImage){
+			usage |= vk::ImageUsageFlagBits::eStorage;
+		}
+		if(features & vk::FormatFeatureFlagBits::eSampledImage){
+			usage |= vk::ImageUsageFlagBits::eSampled;
+		}
+		if(!(usage & (vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled))){
+			throw FormatNotSupported("format " + vk::to_string(format)
+			                         + " can not be used for storage or sampled images");
+		}
+		const auto type = Dim == 2 ? vk::ImageType::e2D : vk::ImageType::e3D;
+		return device.createImage({vk::ImageCreateFlags(), type, format, extent, 1, 1
+		                           , vk::SampleCountFlagBits::e1, vk::ImageTiling::eOptimal, usage
+		                           , vk::SharingMode::eExclusive, 0, nullptr
+		                           , vk::ImageLayout::eUndefined});
+	}
+
+	/// Release resources associated with current image object
+	auto release() noexcept-> void {
+		if(static_cast<vk::Image&>(*this)){
+			_dev->destroyImageView(_view);
+			_dev->freeMemory(_mem);
+			_dev->destroyImage(*this);
+		}
+	}
+private: // data
+	vk::DeviceMemory _mem;   ///< associated chunk of device memory
+	vk::ImageView _view;     ///< view of the whole image
+	vuh::Device* _dev;       ///< refers to underlying logical device
+	uint64_t _id;            ///< unique id of the image (see id())
+	vk::Extent3D _extent;    ///< image dimensions
+	vk::Format _format;      ///< pixel format
+}; // class BasicImage
+
+} // namespace img
+} // namespace vuh
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "basicImage.hpp"
+#include "imageUtils.h"
+
+#include <vuh/arr/copy_async.hpp>
+#include <vuh/delayed.hpp>
+#include <vuh/resource.hpp>
+#include <vuh/traits.hpp>
+
+#include <cassert>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+namespace vuh {
+	namespace detail {
+		/// Command buffer of the device compute pool.
+		/// Image transfers are submitted to the compute queue (see vuh::img), so images never
+		/// change the queue family ownership.
+		struct _ComputeCmdBuffer {
+			/// Constructor. Takes the command buffer from the device (recycled one if there is any)
+			/// and manages its resources.
+			_ComputeCmdBuffer(vuh::Device& device)
+			   : cmd_buffer(device.acquireComputeCmdBuffer()), device(&device)
+			{}
+
+			/// Release the buffer resources. Buffer goes back to the device for reuse.
+			auto release() noexcept-> void {
+				if(device){
+					device->recycleComputeCmdBuffer(cmd_buffer);
+				}
+			}
+
+			/// Submit the recorded command buffer to compute queue.
+			/// @return fence or the timeline point signalled when the submitted work completes
+			auto submit()-> Submission {
+				return device->submitComputeAsync(cmd_buffer);
+			}
+		public: // data
+			vk::CommandBuffer cmd_buffer; ///< command buffer managed by this wrapper class
+			std::unique_ptr<vuh::Device, util::NoopDeleter<vuh::Device>> device; ///< device holding the buffer
+		}; // struct _ComputeCmdBuffer
+
+		/// Movable compute command buffer class.
+		using ComputeCmdBuffer = util::Resource<_ComputeCmdBuffer>;
+
+		/// Keeps the staging array and the command buffer alive till async copy to image completes.
+		/// At construction copies the data from host to the staging buffer.
+		/// Delayed action is a noop.
+		template<class T>
+		struct CopyStageToImage: private ComputeCmdBuffer {
+			using StageArray = arr::HostArray<T, arr::AllocDevice<arr::properties::HostCoherent>>;
+			StageArray array; ///< staging buffer
+
+			/// Constructor. Copies data from host to the internal staging buffer.
+			template<class Iter1, class Iter2>
+			CopyStageToImage(vuh::Device& device, Iter1 src_begin, Iter2 src_end)
+			   : ComputeCmdBuffer(device), array(device, src_begin, src_end)
+			{}
+
+			/// delayed operation is a noop
+			constexpr auto operator()() const-> void {}
+
+			/// Initiate copy of the staging buffer to the image.
+			template<class Image>
+			auto copy_async(Image& image)-> Delayed<> {
+				assert(*device == image.device());
+				cmd_buffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+				img::recordCopyBufToImage(cmd_buffer, array, image, image.extent());
+				cmd_buffer.end();
+				return Delayed<>{submit(), *device};
+			}
+		}; // struct CopyStageToImage
+
+		/// Keeps the staging buffer and the command buffer alive till async copy from image completes.
+		/// Delayed action copies data from staging buffer to the host.
+		template<class T, class IterDst>
+		struct CopyStageFromImage: private ComputeCmdBuffer {
+			using StageArray = arr::HostArray<T, arr::AllocDevice<arr::properties::HostCached>>;
+			StageArray array;      ///< staging buffer
+			IterDst    dst_begin;  ///< iterator to beginning of the host destination range
+
+			/// Constructor.
+			explicit CopyStageFromImage(vuh::Device& device, std::size_t size, IterDst dst_begin)
+			   : ComputeCmdBuffer(device), array(device, size), dst_begin(dst_begin)
+			{}
+
+			/// Initiate copy of the image to the staging buffer.
+			template<class Image>
+			auto copy_async(Image& image)-> Delayed<> {
+				assert(*device == image.device());
+				cmd_buffer.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+				img::recordCopyImageToBuf(cmd_buffer, image, array, image.extent());
+				cmd_buffer.end();
+				return Delayed<>{submit(), *device};
+			}
+
+			/// Delayed action. Copies data from staging buffer to the host.
+			auto operator()() const-> void {
+				using std::begin; using std::end;
+				std::copy(begin(array), end(array), dst_begin);
+			}
+		}; // struct CopyStageFromImage
+	} // namespace detail
+
+	/// Async copy data from host memory to the image.
+	/// Host range should cover the whole image.
+	/// Blocks for the duration of initial copy from host memory to the staging buffer,
+	/// only the transfer between staging buffer and image is actually async.
+	/// The transfer is ordered with the kernels accessing the image and submitted to the
+	/// compute queue, so no explicit synchronization is needed before and after it.
+	template<class SrcIter1, class SrcIter2, class T, uint32_t Dim>
+	auto copy_async(SrcIter1 src_begin, SrcIter2 src_end, img::BasicImage<T, Dim>& dst
+	               )-> std::enable_if_t<traits::are_comparable_host_iterators<SrcIter1, SrcIter2>::value
+	                                   , vuh::Delayed<Copy>
+	                                   >
+	{
+		assert(size_t(std::distance(src_begin, src_end)) == dst.size());
+		auto stage = detail::CopyStageToImage<T>(dst.device(), src_begin, src_end);
+		auto cpy = stage.copy_async(dst);
+		return Delayed<Copy>{std::move(cpy), Copy::wrap(std::move(stage))};
+	}
+
+	/// Async copy of the whole image data to host.
+	/// Initiates async copy from image to the staging buffer and immidiately returns
+	/// the Delayed<Copy> object used for synchronization with host.
+	/// The copy between staging buffer and host is only triggered at the synchronization point.
+	template<class T, uint32_t Dim, class DstIter>
+	auto copy_async(img::BasicImage<T, Dim>& src, DstIter dst_begin
+	               )-> std::enable_if_t<traits::is_host_iterator<DstIter>::value
+	                                   , vuh::Delayed<Copy>
+	                                   >
+	{
+		auto stage = detail::CopyStageFromImage<T, DstIter>(src.device(), src.size(), dst_begin);
+		auto cpy = stage.copy_async(src);
+		return Delayed<Copy>{std::move(cpy), Copy::wrap(std::move(stage))};
+	}
+} // namespace vuh
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "vuh/device.h"
+
+#include <vulkan/vulkan.hpp>
+
+namespace vuh {
+namespace img {
+	auto recordInitLayout(vk::CommandBuffer cmd_buf, vk::Image image)-> void;
+	auto recordCopyBufToImage(vk::CommandBuffer cmd_buf
+	                          , vk::Buffer src, vk::Image dst, vk::Extent3D extent
+	                          )-> void;
+	auto recordCopyImageToBuf(vk::CommandBuffer cmd_buf
+	                          , vk::Image src, vk::Buffer dst, vk::Extent3D extent
+	                          )-> void;
+	auto initLayout(vuh::Device& device, vk::Image image)-> void;
+	auto copyBufToImage(vuh::Device& device, vk::Buffer src, vk::Image dst, vk::Extent3D extent)-> void;
+	auto copyImageToBuf(vuh::Device& device, vk::Image src, vk::Buffer dst, vk::Extent3D extent)-> void;
+} // namespace img
+} // namespace vuh
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <vuh/device.h>
+#include <vuh/error.h>
+#include <vuh/utils.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <string>
+
+namespace vuh {
+namespace img {
+
+/// Image bound to kernels together with a sampler (as a combined image sampler descriptor).
+/// Gives kernels access to the texture units: filtered reads, hardware handling of out-of-range
+/// coordinates and a cache optimized for 2D/3D locality.
+/// Does not own the image, which should outlive the object of this class.
+/// Owns the sampler.
+template<class Image>
+class SampledImage {
+public:
+	using image_type = Image;
+	using value_type = typename Image::value_type;
+	static constexpr auto descriptor_class = vk::DescriptorType::eCombinedImageSampler;
+
+	/// Constructor. Creates the sampler with unnormalized coordinates disabled, so kernels may
+	/// use both texelFetch() with integer coordinates and texture() with normalized ones.
+	/// @throws vuh::FormatNotSupported if linear filter is requested for the format not supporting it.
+	SampledImage(Image& image ///< image to sample, should be created with sampled usage
+	            , vk::Filter filter=vk::Filter::eNearest ///< magnification and minification filter
+	            , vk::SamplerAddressMode mode=vk::SamplerAddressMode::eClampToEdge ///< handling of out-of-range coordinates
+	            )
+	   : _image(&image), _id(unique_id())
+	{
+		auto& device = image.device();
+		const auto features = device.formatProperties(image.format()).optimalTilingFeatures;
+		if(!(features & vk::FormatFeatureFlagBits::eSampledImage)){
+			throw FormatNotSupported("format " + vk::to_string(image.format())
+			                         + " can not be used for sampled images");
+		}
+		if(filter == vk::Filter::eLinear
+		   && !(features & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
+		{
+			throw FormatNotSupported("format " + vk::to_string(image.format())
+			                         + " does not support linear filtering");
+		}
+		_sampler = device.createSampler({vk::SamplerCreateFlags(), filter, filter
+		                                 , vk::SamplerMipmapMode::eNearest, mode, mode, mode
+		                                 , 0.f, false, 1.f, false, vk::CompareOp::eNever
+		                                 , 0.f, 0.f, vk::BorderColor::eFloatTransparentBlack
+		                                 , false});
+	}
+
+	/// Destroy the sampler.
+	~SampledImage() noexcept { release(); }
+
+	SampledImage(const SampledImage&) = delete;
+	SampledImage& operator= (const SampledImage&) = delete;
+
+	/// Move constructor. Passes the sampler ownership.
+	SampledImage(SampledImage&& o) noexcept: _image(o._image), _sampler(o._sampler), _id(o._id) {
+		o._sampler = nullptr;
+	}
+
+	/// Move assignment. Sampler of the current object is destroyed immidiately.
+	auto operator= (SampledImage&& o) noexcept-> SampledImage& {
+		release();
+		_image = o._image;
+		_sampler = o._sampler;
+		_id = o._id;
+		o._sampler = nullptr;
+		return *this;
+	}
+
+	/// @return descriptor info to bind image as a combined image sampler
+	auto image_info() const-> vk::DescriptorImageInfo {
+		return {_sampler, _image->view(), vk::ImageLayout::eGeneral};
+	}
+
+	/// @return underlying image
+	auto image()-> Image& { return *_image; }
+	/// @return sampler handle
+	auto sampler() const-> vk::Sampler { return _sampler; }
+	/// @return reference to device on which underlying image is allocated
+	auto device()-> vuh::Device& { return _image->device(); }
+
+	/// @return id of the (image, sampler) pair. Changes when either is replaced.
+	auto id() const-> uint64_t {
+		const uint64_t ids[] = {_image->id(), _id};
+		return hash_bytes(ids, sizeof(ids));
+	}
+private: // helpers
+	auto release() noexcept-> void {
+		if(_sampler){
+			_image->device().destroySampler(_sampler);
+		}
+	}
+private: // data
+	Image* _image;         ///< sampled image
+	vk::Sampler _sampler;  ///< sampler owned by this object
+	uint64_t _id;          ///< unique id of the sampler
+}; // class SampledImage
+
+} // namespace img
+
+/// Create a SampledImage for the given image.
+template<class Image>
+auto sampled(Image& image
+            , vk::Filter filter=vk::Filter::eNearest
+            , vk::SamplerAddressMode mode=vk::SamplerAddressMode::eClampToEdge
+            )-> img::SampledImage<Image>
+{
+	return img::SampledImage<Image>(image, filter, mode);
+}
+
+} // namespace vuh
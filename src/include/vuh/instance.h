@@ -13,13 +13,15 @@ namespace vuh {
 	/// Its main responsibility is listing the available devices and handling extensions and layers.
 	/// It is also responsible for logging vuh and vulkan messages.
 	/// In debug builds adds default validation layer/extension.
+	/// Requests Vulkan 1.1 by default (so that devices can expose subgroup functionality),
+	/// falling back to 1.0 when that is all the loader supports.
 	/// Default debug reporter sends messages to std::cerr.
 	/// Reentrant.
 	class Instance {
 	public:
 		explicit Instance(const std::vector<const char*>& layers={}
 		                 , const std::vector<const char*>& extensions={}
-		                 , const vk::ApplicationInfo& info={nullptr, 0, nullptr, 0, VK_API_VERSION_1_0}
+		                 , const vk::ApplicationInfo& info={nullptr, 0, nullptr, 0, VK_API_VERSION_1_1}
 		                 , debug_reporter_t report_callback=nullptr
 		                 );
 
@@ -36,12 +38,16 @@ namespace vuh {
 
 		auto layers() const noexcept-> const std::vector<const char*>;
 		auto extensions() const noexcept-> const std::vector<const char*>;
+		auto hasExtension(const char* name) const-> bool;
+		auto getProcAddr(const char* name) const-> PFN_vkVoidFunction;
+		auto apiVersion() const-> uint32_t { return _api_version; }
 
 	private: // helpers
 		auto clear() noexcept-> void;
 	private: // data
 		const std::vector<const char*> _layers; ///< enabled layers
 		const std::vector<const char*> _extensions; ///< enabled extensions
+		uint32_t _api_version;      ///< Vulkan API version the instance was created with
 		vk::Instance _instance;     ///< vulkan instance
 		debug_reporter_t _reporter; ///< points to actual reporting function. This pointer is registered with a reporter callback but can also be used directly.
 		VkDebugReportCallbackEXT _reporter_cbk; ///< report callback. Only used to release the handle in the end.
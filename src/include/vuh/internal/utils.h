@@ -1,5 +1,13 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <vuh/vuh.h>
 
@@ -48,4 +56,56 @@ namespace {
 			}
 		}
 	}
+
+	/// Replace the file content with what the given function writes to the stream.
+	/// Data is first written to a temporary file next to the target one which is then renamed,
+	/// so that concurrent readers and writers never observe a partially written file.
+	/// @throws vuh::FileWriteFailure
+	template<class F>
+	auto write_file_atomic(const std::string& filepath, F&& write)-> void {
+		const auto unique = std::hash<std::thread::id>{}(std::this_thread::get_id())
+		                    ^ size_t(std::chrono::steady_clock::now().time_since_epoch().count());
+		const auto tmppath = filepath + ".tmp" + std::to_string(unique);
+		{
+			auto fout = std::ofstream(tmppath, std::ios::binary | std::ios::trunc);
+			if(!write(fout) || !fout.flush()){
+				std::remove(tmppath.c_str());
+				throw vuh::FileWriteFailure("could not write to " + tmppath);
+			}
+		}
+		if(0 != std::rename(tmppath.c_str(), filepath.c_str())){
+			std::remove(filepath.c_str()); // rename does not replace existing files on some platforms
+			if(0 != std::rename(tmppath.c_str(), filepath.c_str())){
+				std::remove(tmppath.c_str());
+				throw vuh::FileWriteFailure("could not replace file " + filepath);
+			}
+		}
+	}
+
+	/// @return path of the file holding the cached SPIR-V code with a given hash
+	inline auto spirv_cache_path(const std::string& cache_dir, uint64_t hash)-> std::string {
+		auto name = std::ostringstream{};
+		name << std::hex << hash << ".spv";
+		return cache_dir + "/" + name.str();
+	}
+
+	/// Read cached SPIR-V code.
+	/// @return the code, or empty array if the file does not exist or does not hold a SPIR-V module
+	inline auto read_cached_spirv(const std::string& filepath)-> std::vector<char> {
+		auto fin = std::ifstream(filepath, std::ios::binary);
+		if(!fin.is_open()){
+			return {};
+		}
+		auto r = std::vector<char>(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+		if(r.size() < sizeof(uint32_t) || r.size()%sizeof(uint32_t) != 0){
+			return {};
+		}
+		constexpr auto spirv_magic = uint32_t(0x07230203u);
+		auto magic = uint32_t(0);
+		std::memcpy(&magic, r.data(), sizeof(magic));
+		if(magic != spirv_magic){
+			return {};
+		}
+		return r;
+	}
 }
\ No newline at end of file
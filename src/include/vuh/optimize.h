@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <string>
+#include <vector>
+
+namespace vuh {
+	/// SPIR-V optimization recipes of the SPIRV-Tools optimizer.
+	enum class SpirvOpt {
+		None,        ///< no optimization passes
+		Performance, ///< passes improving the run time (as spirv-opt -O)
+		Size         ///< passes reducing the code size (as spirv-opt -Os)
+	};
+
+	auto spirv_opt_supported()-> bool;
+	auto optimize_spirv(const std::vector<char>& code, SpirvOpt recipe
+	                    , const vk::SpecializationInfo* freeze=nullptr
+	                    , const std::string& cache_dir={}, uint32_t api_version=VK_API_VERSION_1_0
+	                    )-> std::vector<char>;
+} // namespace vuh
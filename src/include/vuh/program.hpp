@@ -1,18 +1,37 @@
 #pragma once
 
 #include "array.hpp"
+#include "descriptorRing.hpp"
+#include "uniformRing.hpp"
 #include "device.h"
+#include "error.h"
+#include "optimize.h"
 #include "utils.h"
 #include "delayed.hpp"
 
 #include <vulkan/vulkan.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstring>
+#include <future>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace vuh {
+	/// Default id of the specialization constant the subgroup size is passed to kernels with
+	/// (see Program::spec_subgroup_size()).
+	constexpr uint32_t subgroup_size_id = 100;
+
 	namespace detail {
 
 		/// Traits to map array type to descriptor type
@@ -20,6 +39,107 @@ namespace vuh {
 			static constexpr auto value = T::descriptor_class;
 		};
 
+		/// Array list (std::vector of arrays or array views) maps to the runtime-sized array of
+		/// non-dynamic descriptors.
+		template<class A> struct DictTypeToDsc<std::vector<A>> {
+			static constexpr auto value = static_descriptor(A::descriptor_class);
+		};
+
+		/// Traits to tell the array list parameters from the single array ones
+		template<class T> struct is_array_list: std::false_type {};
+		template<class A> struct is_array_list<std::vector<A>>: std::true_type {};
+
+		/// Traits to check if the last of the types is the array list
+		template<class... Ts> struct last_is_array_list: std::false_type {};
+		template<class T> struct last_is_array_list<T>: is_array_list<T> {};
+		template<class T, class... Ts>
+		struct last_is_array_list<T, Ts...>: last_is_array_list<Ts...> {};
+
+		/// @return number of array lists among the types
+		template<class... Ts>
+		constexpr auto count_array_lists()-> std::size_t {
+			const bool flags[] = {false, is_array_list<Ts>::value...};
+			auto r = std::size_t(0);
+			for(auto f: flags){
+				r += f ? 1 : 0;
+			}
+			return r;
+		}
+
+		/// @return number of elements in the array list parameter, 0 for single array parameters
+		template<class Arr>
+		auto list_size(const Arr&)-> std::size_t { return 0; }
+
+		template<class A>
+		auto list_size(const std::vector<A>& list)-> std::size_t { return list.size(); }
+
+		/// @return id of the array (image) parameter, which unlike its Vulkan handles is not reused
+		/// after the parameter is destroyed. Array list elements are tracked one by one, the list
+		/// itself has no id.
+		template<class Arr>
+		auto resource_id(const Arr& arr)-> uint64_t { return arr.id(); }
+
+		template<class A>
+		auto resource_id(const std::vector<A>&)-> uint64_t { return 0; }
+
+		// helper
+		template<class Arr>
+		auto buffer_info(Arr& arr, std::false_type)-> vk::DescriptorBufferInfo {
+			return {arr.buffer(), 0, arr.size_bytes()};
+		}
+
+		// helper
+		template<class Arr>
+		auto buffer_info(Arr&, std::true_type)-> vk::DescriptorBufferInfo { return {}; }
+
+		/// @return descriptor info for the single array parameter. Offset is filled separately.
+		/// Image parameters have no buffer, this returns just a placeholder for those.
+		template<class Arr>
+		auto buffer_info(Arr& arr)-> vk::DescriptorBufferInfo {
+			using is_image = std::integral_constant<bool, is_image_descriptor(Arr::descriptor_class)>;
+			return buffer_info(arr, is_image{});
+		}
+
+		/// Array lists are written apart from other parameters, this returns just a placeholder.
+		template<class A>
+		auto buffer_info(std::vector<A>&)-> vk::DescriptorBufferInfo { return {}; }
+
+		// helper
+		template<class Arr>
+		auto texel_view(Arr& arr, std::true_type)-> vk::BufferView { return arr.view(); }
+
+		// helper
+		template<class Arr>
+		auto texel_view(Arr&, std::false_type)-> vk::BufferView { return {}; }
+
+		/// @return buffer view of the texel array parameter, null handle for other parameters
+		template<class Arr>
+		auto texel_view(Arr& arr)-> vk::BufferView {
+			using is_texel = std::integral_constant<bool, is_texel_descriptor(Arr::descriptor_class)>;
+			return texel_view(arr, is_texel{});
+		}
+
+		template<class A>
+		auto texel_view(std::vector<A>&)-> vk::BufferView { return {}; }
+
+		// helper
+		template<class Arr>
+		auto image_info(Arr& arr, std::true_type)-> vk::DescriptorImageInfo { return arr.image_info(); }
+
+		// helper
+		template<class Arr>
+		auto image_info(Arr&, std::false_type)-> vk::DescriptorImageInfo { return {}; }
+
+		/// @return descriptor info of the image parameter, empty info for array parameters
+		template<class Arr>
+		auto image_info(Arr& arr)-> vk::DescriptorImageInfo {
+			using is_image = std::integral_constant<bool, is_image_descriptor(Arr::descriptor_class)>;
+			return image_info(arr, is_image{});
+		}
+
+		template<class A>
+		auto image_info(std::vector<A>&)-> vk::DescriptorImageInfo { return {}; }
+
 		/// @return tuple element offset
 		template<size_t Idx, class T>
 		constexpr auto tuple_element_offset(const T& tup)-> std::size_t {
@@ -38,22 +158,58 @@ namespace vuh {
 			          }... }};
 		}
 
-		// helper
+		/// @return descriptor classes of the array parameter types, the table is built compile-time
 		template<class... Ts>
-		auto typesToDscTypes()->std::array<vk::DescriptorType, sizeof...(Ts)> {
-			return {detail::DictTypeToDsc<Ts>::value...};
+		constexpr auto typesToDscTypes()-> std::array<vk::DescriptorType, sizeof...(Ts)> {
+			return {{detail::DictTypeToDsc<Ts>::value...}};
 		}
 
-		// helper
+		/// @return array of descriptor types with dynamic buffer descriptors replaced by non-dynamic ones
+		template<size_t N>
+		auto dscTypesToStatic(std::array<vk::DescriptorType, N> dsc_types
+		                      )-> std::array<vk::DescriptorType, N>
+		{
+			for(auto& t: dsc_types){
+				t = static_descriptor(t);
+			}
+			return dsc_types;
+		}
+
+		/// @return descriptor pool sizes needed to allocate a single set with given descriptors
 		template<size_t N>
-		auto dscTypesToLayout(const std::array<vk::DescriptorType, N>& dsc_types) {
-			auto r = std::array<vk::DescriptorSetLayoutBinding, N>{};
-			for(size_t i = 0; i < N; ++i){ // can be expanded compile-time
-				r[i] = {uint32_t(i), dsc_types[i], 1, vk::ShaderStageFlagBits::eCompute};
+		auto dscTypesToPoolSizes(const std::array<vk::DescriptorType, N>& dsc_types
+		                         )-> std::vector<vk::DescriptorPoolSize>
+		{
+			auto r = std::vector<vk::DescriptorPoolSize>{};
+			for(auto t: dsc_types){
+				auto it = std::find_if(begin(r), end(r), [t](const auto& s){ return s.type == t; });
+				if(it == end(r)){
+					r.emplace_back(t, 1);
+				} else {
+					++it->descriptorCount;
+				}
 			}
 			return r;
 		}
 
+		// helper
+		template<size_t N, size_t... I>
+		auto dscTypesToLayout(const std::array<vk::DescriptorType, N>& dsc_types
+		                      , std::index_sequence<I...>
+		                      )-> std::array<vk::DescriptorSetLayoutBinding, N>
+		{
+			return {{vk::DescriptorSetLayoutBinding(uint32_t(I), dsc_types[I], 1
+			                                        , vk::ShaderStageFlagBits::eCompute)...}};
+		}
+
+		/// @return layout bindings of the array parameters with given descriptor types
+		template<size_t N>
+		auto dscTypesToLayout(const std::array<vk::DescriptorType, N>& dsc_types
+		                      )-> std::array<vk::DescriptorSetLayoutBinding, N>
+		{
+			return dscTypesToLayout(dsc_types, std::make_index_sequence<N>{});
+		}
+
 		/// @return specialization map array
 		template<class... Ts>
 		auto specs2mapentries(const std::tuple<Ts...>& specs
@@ -62,18 +218,37 @@ namespace vuh {
 			return spec2entries(specs, std::make_index_sequence<sizeof...(Ts)>{});
 		}
 
-		// helper
-		template<class T, size_t... I>
-		auto dscinfos2writesets(vk::DescriptorSet dscset, const T& infos
+		/// @return descriptor writes for the array parameters.
+		/// Texel buffers are written from views, images from image infos, other buffers from
+		/// buffer infos.
+		template<class T, class V, class M, size_t... I>
+		auto dscinfos2writesets(vk::DescriptorSet dscset, const T& infos, const V& views
+		                        , const M& images
+		                        , const std::array<vk::DescriptorType, sizeof...(I)>& dsc_types
 		                        , std::index_sequence<I...>
 		                        )-> std::array<vk::WriteDescriptorSet, sizeof...(I)>
 		{
 			auto r = std::array<vk::WriteDescriptorSet, sizeof...(I)>{{
-				{dscset, uint32_t(I), 0, 1, vk::DescriptorType::eStorageBuffer, nullptr, &infos[I]}...
+				{dscset, uint32_t(I), 0, 1, dsc_types[I]
+				, is_image_descriptor(dsc_types[I]) ? &images[I] : nullptr
+				, is_texel_descriptor(dsc_types[I]) || is_image_descriptor(dsc_types[I]) ? nullptr : &infos[I]
+				, is_texel_descriptor(dsc_types[I]) ? &views[I] : nullptr}...
 			}};
 			return r;
 		}
 
+		/// Descriptor state of the array parameters of a single bind.
+		/// Filled over the zeroed storage, so that it may be compared bytewise (padding included).
+		template<size_t N>
+		struct Bindings {
+			std::array<vk::DescriptorBufferInfo, N> dscinfos; ///< buffer infos, offsets of dynamic descriptors are taken out
+			std::array<vk::BufferView, N> views;             ///< texel buffer views
+			std::array<vk::DescriptorImageInfo, N> images;   ///< image infos
+			std::array<uint64_t, N> ids;                     ///< ids of the bound arrays and images (see resource_id())
+			std::array<uint32_t, N> dynoffsets;              ///< offsets of the dynamic descriptors in binding order
+			uint32_t n_dynamic;                              ///< number of dynamic descriptors
+		};
+
 		/// Transient command buffer data with a releaseable interface.
 		struct ComputeBuffer {
 			/// Constructor. Takes ownership over provided buffer.
@@ -81,10 +256,10 @@ namespace vuh {
 			   : cmd_buffer(buffer), device(&device){}
 
 			/// Release resources associated with owned command buffer.
-			/// Buffer is released from device's compute command pool.
+			/// Buffer goes back to the device for reuse.
 			auto release() noexcept-> void {
 				if(device){
-					device->freeCommandBuffers(device->computeCmdPool(), 1, &cmd_buffer);
+					device->recycleComputeCmdBuffer(cmd_buffer);
 				}
 			}
 		public: // data
@@ -93,45 +268,177 @@ namespace vuh {
 		}; // struct ComputeData
 
 		/// Helper class for use as a Delayed<> parameter extending the lifetime of the command
-		/// buffer and a noop triggered action.
+		/// buffer. Triggered action frees the descriptor set and the parameters slot used by
+		/// the computation.
+		/// Busy flags share the ownership of the rings they belong to, so that the descriptor
+		/// pools and the parameters buffer live till the computation completes even if the program
+		/// is destroyed before that.
 		struct Compute: private util::Resource<ComputeBuffer> {
 			/// Constructor
-			explicit Compute(vuh::Device& device, vk::CommandBuffer buffer)
+			explicit Compute(vuh::Device& device, vk::CommandBuffer buffer
+			                 , std::shared_ptr<std::atomic<bool>> dscset_busy={}
+			                 , std::shared_ptr<std::atomic<bool>> params_busy={})
 			   : Resource<ComputeBuffer>(device, std::move(buffer))
+			   , _dscset_busy(std::move(dscset_busy))
+			   , _params_busy(std::move(params_busy))
 			{}
 
-			/// Noop. Action to be triggered when the fence is signaled.
-			constexpr auto operator()() noexcept-> void {}
+			/// Action to be triggered when the fence is signaled.
+			/// Returns the descriptor set to the program's descriptor ring and the parameters slot
+			/// to the program's uniform ring.
+			auto operator()() noexcept-> void {
+				if(_dscset_busy){
+					_dscset_busy->store(false, std::memory_order_release);
+					_dscset_busy.reset();
+				}
+				if(_params_busy){
+					_params_busy->store(false, std::memory_order_release);
+					_params_busy.reset();
+				}
+			}
+		private: // data
+			std::shared_ptr<std::atomic<bool>> _dscset_busy; ///< busy flag of the descriptor set used by the computation
+			std::shared_ptr<std::atomic<bool>> _params_busy; ///< busy flag of the parameters slot used by the computation
 		}; // struct Compute
 
 		/// Program base functionality.
 		/// Initializes and keeps most state variables, and array argument handling building blocks.
 		class ProgramBase {
+			/// Number of push descriptors guaranteed to be supported (maxPushDescriptors lower bound).
+			/// Programs with more array parameters fall back to descriptor sets.
+			static constexpr size_t max_push_descriptors = 32;
+			/// Min number of descriptors reserved for the array list parameter.
+			static constexpr std::size_t min_list_capacity = 64;
+			/// Value of _subgroup_size_id for the programs not passing the subgroup size to kernels.
+			static constexpr uint32_t no_subgroup_size_id = uint32_t(-1);
 		public:
+			/// Push constants size guaranteed to be supported (maxPushConstantsSize lower bound).
+			/// Larger parameter blocks are passed to kernels in uniform buffers.
+			static constexpr std::size_t max_push_constants_size = 128;
+
 			/// Run the Program object on previously bound parameters, wait for completion.
+			/// Waits on the fence of this run rather than for the compute queue to go idle, so that
+			/// work submitted to the queue later (e.g. by other threads) does not hold it. The fence
+			/// still signals only after all work submitted to the queue earlier completes.
 			/// @pre bacth sizes should be specified before calling this.
 			/// @pre all paramerters should be specialized, pushed and bound before calling this.
+			/// @throws std::logic_error if after() was called past the bind (see wait_for()).
 			auto run()-> void {
-				auto submitInfo = vk::SubmitInfo(0, nullptr, nullptr, 1, &_device.computeCmdBuffer()); // submit a single command buffer
-
-				// submit the command buffer to the queue and set up a fence.
-				auto queue = _device.computeQueue();
-				queue.submit({submitInfo}, nullptr);
-				queue.waitIdle();
+				check_acquired();
+				_device.submitSync(_device.computeQueue(), _device.recordedComputeCmdBuffer()
+				                   , _spin.count() < 0 ? _device.syncSpin() : _spin
+				                   , _after.data(), uint32_t(_after.size()));
+				_after.clear();
 			}
 
+			/// Set the time the sync runs poll for completion before blocking the thread
+			/// (see Device::waitFence()). Spinning saves the wake-up latency for the short
+			/// dispatches at the cost of a busy CPU core.
+			/// Negative period (default) means the device's setting (Device::syncSpin()).
+			auto spin_wait(std::chrono::nanoseconds period)-> void { _spin = period; }
+
 			/// Run the Program object on previously bound parameters.
+			/// The descriptor set (and the parameters slot) used by this run is kept busy till
+			/// the returned object is synchronized, and the next bind() writes to another one.
+			/// So the next invocation with other arguments may be issued without waiting for this
+			/// one to complete.
 			/// @return Delayed<Compute> object used for synchronization with host
+			/// @throws std::logic_error if after() was called past the bind (see wait_for()).
 			auto run_async()-> vuh::Delayed<Compute> {
+				check_acquired();
 				auto buffer = _device.releaseComputeCmdBuffer();
-				auto submitInfo = vk::SubmitInfo(0, nullptr, nullptr, 1, &buffer); // submit a single command buffer
+				// fence or timeline point makes sure the control is not returned to CPU till command buffer is depleted
+				const auto submission = _device.submitComputeAsync(buffer, _after.data()
+				                                                   , uint32_t(_after.size()));
+				_after.clear();
+
+				auto dscset_busy = std::shared_ptr<std::atomic<bool>>{};
+				if(_dscslot != DescriptorRing::no_slot){ // flag keeps the ring alive
+					dscset_busy = std::shared_ptr<std::atomic<bool>>(_dscring, _dscring->busy_flag(_dscslot));
+				}
+				_dscslot = DescriptorRing::no_slot;
+				auto params_busy = std::shared_ptr<std::atomic<bool>>{};
+				if(_params_slot != UniformRing::no_slot){
+					params_busy = std::shared_ptr<std::atomic<bool>>(_params_ring
+					                                                 , _params_ring->busy_flag(_params_slot));
+				}
+				_params_slot = UniformRing::no_slot;
+				return Delayed<Compute>{submission, _device
+				                       , Compute(_device, buffer, std::move(dscset_busy)
+				                                 , std::move(params_busy))};
+			}
+
+			/// Make the next run (sync or async) start after the operation behind a given token
+			/// completes.
+			/// If the device supports timeline semaphores (see DeviceFeatures::timeline_semaphore)
+			/// the wait happens on the device and this call returns immediately, so that chained
+			/// operations need no host round trip in between. Otherwise the token is waited for
+			/// right here.
+			/// If the operation released the buffer range it has written to the compute queue family
+			/// (async copies with exclusive queue sharing, see Device::queueSharing()) the next
+			/// bind records acquiring that range, so this should be called before the bind
+			/// (run with arguments does the bind). The run past the bind throws otherwise.
+			/// The token still has to be synchronized as usual to release its resources.
+			/// @pre the operation should run on the same device as the program.
+			template<class Action>
+			auto wait_for(Delayed<Action>& token)-> void {
+				const auto acquire = token.acquire_barrier();
+				if(acquire.buffer){
+					_acquire.push_back(acquire);
+				}
+				if(token.point().semaphore){
+					_after.push_back(token.point());
+				} else {
+					token.wait();
+				}
+			}
 
-				// submit the command buffer to the queue and set up a fence.
-				auto queue = _device.computeQueue();
-				auto fence = _device.createFence(vk::FenceCreateInfo()); // fence makes sure the control is not returned to CPU till command buffer is depleted
-				queue.submit({submitInfo}, fence);
+			/// Turn on/off the timing of the dispatches with GPU timestamps.
+			/// Takes effect at the next bind. Timing makes sense for sync runs only, async runs in
+			/// flight would overwrite the timestamps of each other.
+			/// @return false if timestamps are not supported by the device compute queue
+			auto timing(bool on)-> bool {
+				if(on && !_query_pool && _device.timestampValidBits() > 0){
+					_query_pool = _device.createQueryPool({vk::QueryPoolCreateFlags()
+					                                      , vk::QueryType::eTimestamp, 2});
+				} else if(!on && _query_pool){
+					_device.destroyQueryPool(_query_pool);
+					_query_pool = nullptr;
+					_record_version = 0; // recorded commands refer to the destroyed pool
+				}
+				return bool(_query_pool) == on;
+			}
+
+			/// @return duration of the last timed run measured with GPU timestamps.
+			/// Indirect runs are timed like the plain ones, sliced runs are timed from the start
+			/// of the first slice to the end of the last one (gaps between slices included).
+			/// Waits for the timestamps to be available.
+			/// @pre timing should be on and program run since it was turned on.
+			auto last_duration() const-> std::chrono::nanoseconds {
+				assert(_query_pool);
+				uint64_t stamps[2] = {0, 0};
+				(void)_device.getQueryPoolResults(_query_pool, 0, 2, sizeof(stamps), stamps
+				                                  , sizeof(uint64_t), vk::QueryResultFlagBits::e64
+				                                                      | vk::QueryResultFlagBits::eWait);
+				const auto bits = _device.timestampValidBits();
+				const auto mask = bits < 64 ? (uint64_t(1) << bits) - 1 : ~uint64_t(0);
+				const auto ticks = (stamps[1] - stamps[0]) & mask;
+				return std::chrono::nanoseconds(int64_t(double(ticks)
+				                                        *_device.properties().limits.timestampPeriod));
+			}
+
+			/// @return hash of the kernel SPIR-V code. Identifies the kernel in the tuning database.
+			auto kernel_hash() const-> uint64_t { return _code_hash; }
+
+			/// @return device the program runs on
+			auto device()-> vuh::Device& { return _device; }
 
-				return Delayed<Compute>{fence, _device, Compute(_device, buffer)};
+			/// @return subgroup size the kernel is specialized with (if asked to, see
+			/// set_subgroup_size_id()). That is the required size if one was set, or the device's
+			/// subgroup size otherwise. Without the required size some devices may still run
+			/// the kernel with subgroups of another size, so use gl_SubgroupSize where exact value matters.
+			auto subgroup_size() const-> uint32_t {
+				return _required_subgroup ? _required_subgroup : _device.features().subgroup_size;
 			}
 		protected:
 			/// Construct object using given a vuh::Device and path to SPIR-V shader code.
@@ -143,15 +450,37 @@ namespace vuh {
 			{}
 
 			/// Construct object using given a vuh::Device a SPIR-V shader code.
+			/// The code is kept for the optimization (see set_optimization()).
+			ProgramBase(vuh::Device& device              ///< device used to run the code
+			            , std::vector<char> code         ///< actual binary SPIR-V shader code
+			            , vk::ShaderModuleCreateFlags flags={}
+			            )
+			   : _code(std::move(code))
+			   , _shader_flags(flags)
+			   , _code_hash(hash_bytes(_code.data(), _code.size()))
+			   , _device(device)
+			{
+				_shader = device.sharedShaderModule(reinterpret_cast<const uint32_t*>(_code.data())
+				                                    , _code.size(), flags);
+			}
+
+			/// Construct object using given a vuh::Device a SPIR-V shader code.
+			/// Shader module is taken from the device's registry of shared objects, so programs
+			/// with the same code share the module.
+			/// The code is not copied (unless it is to be optimized), so it should outlive
+			/// the program, as the code embedded in the executable does.
 			ProgramBase(vuh::Device& device              ///< device used to run the code
-			            , const std::vector<char>& code  ///< actual binary SPIR-V shader code
+			            , const uint32_t* code           ///< actual binary SPIR-V shader code
+			            , std::size_t n_words            ///< size of the code (number of 32-bit words)
 			            , vk::ShaderModuleCreateFlags flags={}
 			            )
-			   : _device(device)
+			   : _embedded(code)
+			   , _embedded_words(n_words)
+			   , _shader_flags(flags)
+			   , _code_hash(hash_bytes(code, n_words*sizeof(uint32_t)))
+			   , _device(device)
 			{
-				_shader = device.createShaderModule({ flags, uint32_t(code.size())
-				                                    , reinterpret_cast<const uint32_t*>(code.data())
-				                                    });
+				_shader = device.sharedShaderModule(code, n_words*sizeof(uint32_t), flags);
 			}
 
 			/// Destroy the object and release associated resources.
@@ -166,9 +495,33 @@ namespace vuh {
 			ProgramBase(ProgramBase&& o) noexcept
 			   : _shader(o._shader)
 			   , _dsclayout(o._dsclayout)
-			   , _dscpool(o._dscpool)
-			   , _dscset(o._dscset)
-			   , _pipecache(o._pipecache)
+			   , _dscring(std::move(o._dscring))
+			   , _dscslot(o._dscslot)
+			   , _push_descriptors(o._push_descriptors)
+			   , _list_capacity(o._list_capacity)
+			   , _dsc_types(std::move(o._dsc_types))
+			   , _list_infos(std::move(o._list_infos))
+			   , _list_ids(std::move(o._list_ids))
+			   , _list_writes(std::move(o._list_writes))
+			   , _params_ring(std::move(o._params_ring))
+			   , _params_slot(o._params_slot)
+			   , _query_pool(o._query_pool)
+			   , _record_key(std::move(o._record_key))
+			   , _next_key(std::move(o._next_key))
+			   , _record_version(o._record_version)
+			   , _spin(o._spin)
+			   , _after(std::move(o._after))
+			   , _acquire(std::move(o._acquire))
+			   , _code(std::move(o._code))
+			   , _embedded(o._embedded)
+			   , _embedded_words(o._embedded_words)
+			   , _shader_flags(o._shader_flags)
+			   , _opt(o._opt)
+			   , _opt_freeze(o._opt_freeze)
+			   , _opt_cache(std::move(o._opt_cache))
+			   , _code_hash(o._code_hash)
+			   , _required_subgroup(o._required_subgroup)
+			   , _subgroup_size_id(o._subgroup_size_id)
 			   , _pipelayout(o._pipelayout)
 			   , _pipeline(o._pipeline)
 			   , _device(o._device)
@@ -184,9 +537,33 @@ namespace vuh {
 				// member-wise copy
 				_shader     = o._shader;
 				_dsclayout  = o._dsclayout;
-				_dscpool    = o._dscpool;
-				_dscset     = o._dscset;
-				_pipecache  = o._pipecache; 
+				_dscring    = std::move(o._dscring);
+				_dscslot    = o._dscslot;
+				_push_descriptors = o._push_descriptors;
+				_list_capacity = o._list_capacity;
+				_dsc_types = std::move(o._dsc_types);
+				_list_infos = std::move(o._list_infos);
+				_list_ids = std::move(o._list_ids);
+				_list_writes = std::move(o._list_writes);
+				_params_ring = std::move(o._params_ring);
+				_params_slot = o._params_slot;
+				_query_pool = o._query_pool;
+				_record_key = std::move(o._record_key);
+				_next_key   = std::move(o._next_key);
+				_record_version = o._record_version;
+				_spin       = o._spin;
+				_after      = std::move(o._after);
+				_acquire    = std::move(o._acquire);
+				_code       = std::move(o._code);
+				_embedded   = o._embedded;
+				_embedded_words = o._embedded_words;
+				_shader_flags = o._shader_flags;
+				_opt        = o._opt;
+				_opt_freeze = o._opt_freeze;
+				_opt_cache  = std::move(o._opt_cache);
+				_code_hash  = o._code_hash;
+				_required_subgroup = o._required_subgroup;
+				_subgroup_size_id = o._subgroup_size_id;
 				_pipelayout	= o._pipelayout;
 				_pipeline   = o._pipeline;
 				_device     = o._device;
@@ -197,86 +574,836 @@ namespace vuh {
 			}
 
 			/// Release resources associated with current object.
+			/// Shared objects (shader module and layouts) are returned to the device's registry.
 			auto release() noexcept-> void {
 				if(_shader){
-					_device.destroyShaderModule(_shader);
-					_device.destroyDescriptorPool(_dscpool);
-					_device.destroyDescriptorSetLayout(_dsclayout);
-					_device.destroyPipelineCache(_pipecache);
+					_device.releaseShared(_shader);
+					_dscring.reset(); // rings in use by the async runs live till those complete
+					_params_ring.reset();
+					_device.destroyQueryPool(_query_pool);
 					_device.destroyPipeline(_pipeline);
-					_device.destroyPipelineLayout(_pipelayout);
+					_device.releaseShared(_pipelayout);
+					_device.releaseShared(_dsclayout);
 				}
 			}
 
 			/// Initialize the pipeline.
-			/// Creates descriptor set layout, pipeline cache and the pipeline layout.
+			/// Creates descriptor set layout and the pipeline layout, or takes those from the
+			/// device's registry of shared objects if another program has created the same already.
+			/// If the parameters are passed in uniform buffer (see init_params_ring()) their
+			/// descriptor set goes to set 1.
+			/// The array list parameter (if any) is bound to the variable-sized update-after-bind
+			/// binding, with the capacity reserved for the size of the list passed at the first bind.
+			/// Descriptors are pushed (VK_KHR_push_descriptor) unless there is the array list or
+			/// array views, the views take dynamic descriptors on every device then.
+			/// @throws vuh::ExtensionNotFound if array list is passed to the device not supporting
+			/// descriptor indexing.
 			template<size_t N, class... Arrs>
-			auto init_pipelayout(const std::array<vk::PushConstantRange, N>& psrange, Arrs&...)-> void {
-				auto dscTypes = typesToDscTypes<Arrs...>();
+			auto init_pipelayout(const std::array<vk::PushConstantRange, N>& psrange
+			                     , Arrs&... arrs
+			                     )-> void
+			{
+				constexpr auto has_list = last_is_array_list<Arrs...>::value;
+				static_assert(count_array_lists<Arrs...>() == (has_list ? 1u : 0u)
+				              , "only the last array parameter may be the array list");
+				constexpr auto declared = typesToDscTypes<Arrs...>();
+				const auto has_views = std::any_of(begin(declared), end(declared)
+				                                   , [](auto t){ return is_dynamic_descriptor(t); });
+				_push_descriptors = !has_list && !has_views && _device.supportsPushDescriptors()
+				                    && sizeof...(Arrs) <= max_push_descriptors;
+				auto dscTypes = dsc_types<Arrs...>();
+				_dsc_types.assign(begin(dscTypes), end(dscTypes));
 				auto bindings = dscTypesToLayout(dscTypes);
-				_dsclayout = _device.createDescriptorSetLayout(
-				                                       { vk::DescriptorSetLayoutCreateFlags()
-				                                       , uint32_t(bindings.size()), bindings.data()
-				                                       });
-				_pipecache = _device.createPipelineCache({});
-				_pipelayout = _device.createPipelineLayout(
-				        {vk::PipelineLayoutCreateFlags(), 1, &_dsclayout, uint32_t(N), psrange.data()});
+				auto flags = _push_descriptors
+				             ? vk::DescriptorSetLayoutCreateFlags(
+				                       vk::DescriptorSetLayoutCreateFlagBits::ePushDescriptorKHR)
+				             : vk::DescriptorSetLayoutCreateFlags();
+				auto layoutCI = vk::DescriptorSetLayoutCreateInfo(flags, uint32_t(bindings.size())
+				                                                  , bindings.data());
+				auto binding_flags = std::array<vk::DescriptorBindingFlagsEXT, sizeof...(Arrs)>{};
+				auto binding_flagsCI = vk::DescriptorSetLayoutBindingFlagsCreateInfoEXT(
+				                              uint32_t(binding_flags.size()), binding_flags.data());
+				_list_capacity = 0;
+				if(has_list){
+					_list_capacity = list_capacity(std::max({std::size_t(0), list_size(arrs)...}));
+					bindings.back().descriptorCount = _list_capacity;
+					binding_flags.back() = vk::DescriptorBindingFlagBitsEXT::eUpdateAfterBind
+					                     | vk::DescriptorBindingFlagBitsEXT::eUpdateUnusedWhilePending
+					                     | vk::DescriptorBindingFlagBitsEXT::ePartiallyBound
+					                     | vk::DescriptorBindingFlagBitsEXT::eVariableDescriptorCount;
+					layoutCI.flags |= vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPoolEXT;
+					layoutCI.pNext = &binding_flagsCI;
+				}
+				auto dsc_key = std::string(reinterpret_cast<const char*>(bindings.data())
+				                           , bindings.size()*sizeof(vk::DescriptorSetLayoutBinding));
+				dsc_key.append(reinterpret_cast<const char*>(&layoutCI.flags), sizeof(layoutCI.flags));
+				dsc_key.append(reinterpret_cast<const char*>(binding_flags.data())
+				               , binding_flags.size()*sizeof(vk::DescriptorBindingFlagsEXT));
+				_dsclayout = _device.sharedDescriptorSetLayout(dsc_key, layoutCI);
+				const auto setlayouts = std::array<vk::DescriptorSetLayout, 2>{{_dsclayout
+				                  , _params_ring ? _params_ring->layout() : vk::DescriptorSetLayout{}}};
+				const auto pipeCI = vk::PipelineLayoutCreateInfo(vk::PipelineLayoutCreateFlags()
+				                                                 , _params_ring ? 2u : 1u
+				                                                 , setlayouts.data()
+				                                                 , uint32_t(N), psrange.data());
+				auto pipe_key = std::string(reinterpret_cast<const char*>(setlayouts.data())
+				                            , pipeCI.setLayoutCount*sizeof(setlayouts[0]));
+				pipe_key.append(reinterpret_cast<const char*>(psrange.data())
+				                , N*sizeof(vk::PushConstantRange));
+				_pipelayout = _device.sharedPipelineLayout(pipe_key, pipeCI);
+			}
+
+			/// Initialize the ring of uniform buffer slots to pass the parameter blocks of a given
+			/// size (bytes). Should be called before init_pipelayout().
+			auto init_params_ring(std::size_t params_size)-> void {
+				_params_ring = std::make_shared<UniformRing>(_device, params_size);
+				_params_slot = UniformRing::no_slot;
+			}
+
+			/// Write parameters to the uniform buffer slot.
+			auto write_params(const void* params)-> void {
+				if(_params_slot == UniformRing::no_slot){ // previous slot was given away to async run
+					_params_slot = _params_ring->acquire();
+				}
+				_params_ring->write(_params_slot, params);
+			}
+
+			/// Bind the uniform buffer slot the parameters were written to to set 1.
+			/// @pre command buffer should be in the recording state.
+			auto bind_params()-> void {
+				const auto dscset = _params_ring->set(_params_slot);
+				const auto offset = _params_ring->offset(_params_slot);
+				_device.computeCmdBuffer().bindDescriptorSets(vk::PipelineBindPoint::eCompute
+				                                              , _pipelayout, 1, 1, &dscset, 1, &offset);
 			}
 
-			/// Allocates descriptors sets
+			/// Initializes the ring of descriptor sets. Sets themselves are allocated on demand.
+			/// Noop if descriptors are pushed directly to command buffer.
 			template<class... Arrs>
 			auto alloc_descriptor_sets(Arrs&...)-> void {
 				assert(_dsclayout);
-				auto sbo_descriptors_size = vk::DescriptorPoolSize(vk::DescriptorType::eStorageBuffer
-				                                                   , sizeof...(Arrs));
-				auto descriptor_sizes = std::array<vk::DescriptorPoolSize, 1>({sbo_descriptors_size}); // can be done compile-time, but not worth it
-				_dscpool = _device.createDescriptorPool(
-				                             {vk::DescriptorPoolCreateFlags(), 1 // 1 here is the max number of descriptor sets that can be allocated from the pool
-				                              , uint32_t(descriptor_sizes.size()), descriptor_sizes.data()
-				                              });
-				_dscset = _device.allocateDescriptorSets({_dscpool, 1, &_dsclayout})[0];
+				if(_push_descriptors){
+					return;
+				}
+				const auto dscTypes = layout_types<sizeof...(Arrs)>();
+				auto sizes = dscTypesToPoolSizes(dscTypes);
+				if(_list_capacity > 0){ // array list binding takes the whole capacity, not one descriptor
+					for(auto& s: sizes){
+						if(s.type == dscTypes.back()){
+							s.descriptorCount += _list_capacity - 1;
+						}
+					}
+				}
+				_dscring = std::make_shared<DescriptorRing>(_device, _dsclayout, std::move(sizes)
+				                                            , _list_capacity);
+				_dscslot = DescriptorRing::no_slot;
 			}
 
-			/// Starts writing to the device's compute command buffer.
-			/// Binds a pipeline and a descriptor set.
+			/// @return number of descriptors to reserve for the array list of a given size.
+			/// That is the smallest power of 2 (but not less than min_list_capacity) fitting the list,
+			/// limited by what the device supports.
+			/// @throws vuh::ExtensionNotFound if device does not support descriptor indexing
+			/// @throws std::length_error if the list does not fit the device limits
+			auto list_capacity(std::size_t size) const-> uint32_t {
+				const auto& features = _device.features();
+				if(!features.descriptor_indexing){
+					throw ExtensionNotFound("VK_EXT_descriptor_indexing (needed to bind array lists)");
+				}
+				auto r = min_list_capacity;
+				while(r < size){
+					r *= 2;
+				}
+				r = std::min(r, std::size_t(features.max_update_after_bind_buffers));
+				if(r < size){
+					throw std::length_error("array list is larger than device supports");
+				}
+				return uint32_t(r);
+			}
+
+			/// @return descriptor types of array parameters as used in the descriptor set layout.
+			/// Push descriptor layouts and update-after-bind layouts (those with the array list)
+			/// may not have dynamic descriptors, these are replaced by non-dynamic ones.
+			/// Same happens if there are more dynamic descriptors than the device supports in a
+			/// single set.
 			template<class... Arrs>
-			auto command_buffer_begin(Arrs&... arrs)-> void {
-				assert(_pipeline); /// pipeline supposed to be initialized before this
+			auto dsc_types() const-> std::array<vk::DescriptorType, sizeof...(Arrs)> {
+				constexpr auto r = typesToDscTypes<Arrs...>();
+				const auto& limits = _device.properties().limits;
+				const auto n_storage = std::count(begin(r), end(r), vk::DescriptorType::eStorageBufferDynamic);
+				const auto n_uniform = std::count(begin(r), end(r), vk::DescriptorType::eUniformBufferDynamic)
+				                       + (_params_ring ? 1 : 0);
+				if(_push_descriptors || last_is_array_list<Arrs...>::value
+				   || uint32_t(n_storage) > limits.maxDescriptorSetStorageBuffersDynamic
+				   || uint32_t(n_uniform) > limits.maxDescriptorSetUniformBuffersDynamic)
+				{
+					return dscTypesToStatic(r);
+				}
+				return r;
+			}
+
+			/// @return descriptor types of the layout set up at the first bind
+			template<size_t N>
+			auto layout_types() const-> std::array<vk::DescriptorType, N> {
+				assert(_dsc_types.size() == N);
+				auto r = std::array<vk::DescriptorType, N>{};
+				std::copy(begin(_dsc_types), end(_dsc_types), begin(r));
+				return r;
+			}
+
+			/// @return offset (bytes) of the array parameter of given descriptor type wrt its buffer.
+			/// Images have no offset.
+			template<class Arr>
+			auto byte_offset(const Arr& arr) const-> vk::DeviceSize {
+				using is_image = std::integral_constant<bool, is_image_descriptor(Arr::descriptor_class)>;
+				return byte_offset(arr, is_image{});
+			}
+
+			// helper
+			template<class Arr>
+			auto byte_offset(const Arr&, std::true_type) const-> vk::DeviceSize { return 0; }
+
+			// helper
+			template<class Arr>
+			auto byte_offset(const Arr& arr, std::false_type) const-> vk::DeviceSize {
+				return vk::DeviceSize(arr.offset()*sizeof(typename Arr::value_type));
+			}
+
+			/// Array list elements carry their offsets in descriptors, the list itself has none.
+			template<class A>
+			auto byte_offset(const std::vector<A>&) const-> vk::DeviceSize { return 0; }
+
+			/// Collect descriptor infos of the array list elements. Noop for single array parameters.
+			template<class Arr>
+			auto collect_list_infos(Arr&)-> void {}
+
+			template<class A>
+			auto collect_list_infos(std::vector<A>& list)-> void {
+				static_assert(!is_texel_descriptor(A::descriptor_class)
+				              && !is_image_descriptor(A::descriptor_class)
+				              , "texel arrays and images can not be passed in array lists");
+				if(list.size() > _list_capacity){
+					throw std::length_error("array list is larger than the capacity reserved at first bind");
+				}
+				_list_infos.clear();
+				_list_ids.clear();
+				for(auto& a: list){
+					_list_infos.emplace_back(a.buffer(), byte_offset(a), a.size_bytes());
+					_list_ids.push_back(a.id());
+				}
+			}
+
+			/// Write the array list to the variable-sized binding of the descriptor set.
+			/// Only the elements differing from those previously written (as recorded in the set's
+			/// contents starting from a given position: infos of all elements, then their ids)
+			/// are updated, consecutive changed elements are written at once.
+			auto write_list(vk::DescriptorSet dscset, uint32_t binding, vk::DescriptorType type
+			                , const std::vector<char>& contents, std::size_t pos
+			                )-> void
+			{
+				constexpr auto info_size = sizeof(vk::DescriptorBufferInfo);
+				constexpr auto id_size = sizeof(uint64_t);
+				const auto n_old = contents.size() > pos ? (contents.size() - pos)/(info_size + id_size) : 0;
+				auto same = [&](std::size_t i){
+					return i < n_old
+					       && 0 == std::memcmp(contents.data() + pos + i*info_size
+					                           , &_list_infos[i], info_size)
+					       && 0 == std::memcmp(contents.data() + pos + n_old*info_size + i*id_size
+					                           , &_list_ids[i], id_size);
+				};
+				auto& writes = _list_writes;
+				writes.clear();
+				for(std::size_t i = 0; i < _list_infos.size();){
+					if(same(i)){
+						++i;
+						continue;
+					}
+					auto j = i + 1;
+					while(j < _list_infos.size() && !same(j)){
+						++j;
+					}
+					writes.emplace_back(dscset, binding, uint32_t(i), uint32_t(j - i), type
+					                    , nullptr, &_list_infos[i]);
+					i = j;
+				}
+				if(!writes.empty()){
+					_device.updateDescriptorSets(uint32_t(writes.size()), writes.data(), 0, nullptr);
+				}
+			}
 
+			/// Collect the descriptor state of the array parameters, array list element infos and ids
+			/// go to _list_infos and _list_ids. Acquires the descriptor set to write those to,
+			/// unless the descriptors are pushed.
+			/// Descriptor types are those of the layout set up at the first bind, so arrays and views
+			/// may be interchanged: an array passed to the dynamic descriptor takes offset 0,
+			/// a view passed to the plain one has its offset in the buffer info.
+			template<class... Arrs>
+			auto collect_bindings(Arrs&... arrs)-> Bindings<sizeof...(Arrs)> {
 				constexpr auto N = sizeof...(arrs);
-				auto dscinfos = std::array<vk::DescriptorBufferInfo, N>{
-					                           {{arrs.buffer()
-				                               , arrs.offset()*sizeof(typename Arrs::value_type)
-				                               , arrs.size_bytes()}... }
-				                };
-				auto write_dscsets = dscinfos2writesets(_dscset, dscinfos
-				                                       , std::make_index_sequence<N>{});
-				_device.updateDescriptorSets(write_dscsets, {}); // associate buffers to binding points in bindLayout
-
-				// Start recording commands into the newly allocated command buffer.
-				//	auto beginInfo = vk::CommandBufferBeginInfo(vk::CommandBufferUsageFlagBits::eOneTimeSubmit); // buffer is only submitted and used once
-				auto cmdbuf = _device.computeCmdBuffer();
-				auto beginInfo = vk::CommandBufferBeginInfo();
-				cmdbuf.begin(beginInfo);
+				auto r = Bindings<N>{};
+				std::memset(&r, 0, sizeof(r));
+				const auto dscTypes = layout_types<N>();
+				assert(dscTypesToStatic(dscTypes) == dscTypesToStatic(typesToDscTypes<Arrs...>()));
+				const auto offsets = std::array<vk::DeviceSize, N>{{byte_offset(arrs)...}};
+				const vk::DescriptorBufferInfo dscinfos[] = {vk::DescriptorBufferInfo{}, buffer_info(arrs)...};
+				const vk::BufferView views[] = {vk::BufferView{}, texel_view(arrs)...};
+				const vk::DescriptorImageInfo images[] = {vk::DescriptorImageInfo{}, image_info(arrs)...};
+				const uint64_t ids[] = {0, resource_id(arrs)...};
+				for(size_t i = 0; i < N; ++i){
+					r.dscinfos[i].buffer = dscinfos[i + 1].buffer;
+					r.dscinfos[i].range = dscinfos[i + 1].range;
+					if(is_dynamic_descriptor(dscTypes[i])){
+						r.dynoffsets[r.n_dynamic++] = uint32_t(offsets[i]);
+					} else {
+						r.dscinfos[i].offset = offsets[i];
+					}
+					r.views[i] = views[i + 1];
+					r.images[i].sampler = images[i + 1].sampler;
+					r.images[i].imageView = images[i + 1].imageView;
+					r.images[i].imageLayout = images[i + 1].imageLayout;
+					r.ids[i] = ids[i + 1];
+				}
+				(void)std::initializer_list<int>{0, (collect_list_infos(arrs), 0)...};
+				if(!_push_descriptors && _dscslot == DescriptorRing::no_slot){ // previous set was given away to async run
+					_dscslot = _dscring->acquire();
+				}
+				return r;
+			}
+
+			/// Starts writing to the device's compute command buffer.
+			/// Binds a pipeline and the array parameters. These are either pushed directly to
+			/// the command buffer (VK_KHR_push_descriptor), or written to a descriptor set which is
+			/// then bound.
+			/// Offsets of the parameters bound to dynamic descriptors (array views) are passed at the
+			/// bind time and the set is only updated when the rest of its content changes.
+			/// Array list is written element-wise, only the changed elements are updated.
+			/// Set content is not even compared if it is known to be the same (see record()).
+			template<size_t N>
+			auto command_buffer_begin(const Bindings<N>& b
+			                          , const std::array<vk::DescriptorType, N>& dscTypes
+			                          , bool same_bindings=false
+			                          )-> void
+			{
+				assert(_pipeline); /// pipeline supposed to be initialized before this
+				const auto n_fixed = N - (_list_capacity > 0 ? 1 : 0);
+
+				// Start recording commands into the device compute command buffer.
+				auto cmdbuf = _device.beginComputeCmdBuffer();
+				if(!_acquire.empty()){ // take over the buffers released by the operations this run waits for
+					cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe
+					                       , vk::PipelineStageFlagBits::eComputeShader
+					                         | vk::PipelineStageFlagBits::eDrawIndirect
+					                       , {}, 0, nullptr, uint32_t(_acquire.size()), _acquire.data()
+					                       , 0, nullptr);
+					_acquire.clear();
+				}
 
 				// Before dispatch bind a pipeline, AND a descriptor set.
 				cmdbuf.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline);
+				if(_push_descriptors){
+					auto write_dscsets = dscinfos2writesets(vk::DescriptorSet{}, b.dscinfos, b.views
+					                                        , b.images, dscTypes
+					                                        , std::make_index_sequence<N>{});
+					_device.cmdPushDescriptorSet(cmdbuf, _pipelayout, uint32_t(N), write_dscsets.data());
+					return;
+				}
+				const auto dscset = _dscring->set(_dscslot);
+				if(!same_bindings){
+					auto& contents = _dscring->contents(_dscslot);
+					// contents record is: buffer infos, texel views, image infos, ids,
+					// array list infos, array list ids.
+					// Ids tell the new arrays from the destroyed ones that had the same handles.
+					const auto dscinfos_bytes = reinterpret_cast<const char*>(b.dscinfos.data());
+					const auto views_bytes = reinterpret_cast<const char*>(b.views.data());
+					const auto images_bytes = reinterpret_cast<const char*>(b.images.data());
+					const auto ids_bytes = reinterpret_cast<const char*>(b.ids.data());
+					constexpr auto fixed_size = sizeof(b.dscinfos) + sizeof(b.views) + sizeof(b.images)
+					                            + sizeof(b.ids);
+					const auto changed = contents.size() < fixed_size
+					                     || !std::equal(dscinfos_bytes, dscinfos_bytes + sizeof(b.dscinfos)
+					                                    , begin(contents))
+					                     || !std::equal(views_bytes, views_bytes + sizeof(b.views)
+					                                    , begin(contents) + sizeof(b.dscinfos))
+					                     || !std::equal(images_bytes, images_bytes + sizeof(b.images)
+					                                    , begin(contents) + sizeof(b.dscinfos) + sizeof(b.views))
+					                     || !std::equal(ids_bytes, ids_bytes + sizeof(b.ids)
+					                                    , begin(contents) + sizeof(b.dscinfos) + sizeof(b.views)
+					                                      + sizeof(b.images));
+					if(changed){
+						auto write_dscsets = dscinfos2writesets(dscset, b.dscinfos, b.views, b.images
+						                                        , dscTypes, std::make_index_sequence<N>{});
+						// associate buffers to binding points in bindLayout
+						_device.updateDescriptorSets(uint32_t(n_fixed), write_dscsets.data(), 0, nullptr);
+					}
+					if(n_fixed < N){
+						write_list(dscset, uint32_t(N - 1), dscTypes[N - 1], contents, fixed_size);
+					}
+					if(changed || n_fixed < N){
+						const auto list_bytes = reinterpret_cast<const char*>(_list_infos.data());
+						const auto list_ids_bytes = reinterpret_cast<const char*>(_list_ids.data());
+						contents.assign(dscinfos_bytes, dscinfos_bytes + sizeof(b.dscinfos));
+						contents.insert(end(contents), views_bytes, views_bytes + sizeof(b.views));
+						contents.insert(end(contents), images_bytes, images_bytes + sizeof(b.images));
+						contents.insert(end(contents), ids_bytes, ids_bytes + sizeof(b.ids));
+						contents.insert(end(contents), list_bytes
+						                , list_bytes + _list_infos.size()*sizeof(vk::DescriptorBufferInfo));
+						contents.insert(end(contents), list_ids_bytes
+						                , list_ids_bytes + _list_ids.size()*sizeof(uint64_t));
+					}
+				}
 				cmdbuf.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _pipelayout
-				                          , 0, {_dscset}, {});
+				                          , 0, 1, &dscset, b.n_dynamic, b.dynoffsets.data());
+			}
+
+			/// Starts writing to the device's compute command buffer with given array parameters.
+			/// Descriptor set content is then not known to be what the last record() has left.
+			template<class... Arrs>
+			auto command_buffer_begin(Arrs&... arrs)-> void {
+				_record_key.clear();
+				_record_version = 0;
+				const auto b = collect_bindings(arrs...);
+				command_buffer_begin(b, layout_types<sizeof...(Arrs)>());
+			}
+
+			/// Begin the command buffer, bind the array parameters and pass the parameters, either
+			/// pushing them or binding the uniform buffer slot they were written to.
+			/// Parameters of zero size are not passed.
+			template<class... Arrs>
+			auto record_begin(const void* params, std::size_t params_size, Arrs&... arrs)-> void {
+				if(_params_ring){
+					write_params(params);
+				}
+				command_buffer_begin(arrs...);
+				record_params(params, params_size);
+			}
+
+			/// Record the device's compute command buffer up to the dispatch like record_begin()
+			/// does, then let the given function record the dispatch and end the buffer.
+			/// Recording is skipped when the buffer still holds what the previous call recorded,
+			/// with the same pipeline, array parameters, parameters, timing state and dispatch key.
+			/// Then the buffer is just submitted again.
+			/// Array parameters are told apart by their ids, so that an array created in place of
+			/// the destroyed one (and given the same buffer handle) does not replay a stale record.
+			/// If only the parameters or the dispatch changed the buffer is re-recorded, but
+			/// the descriptor set is known to be up to date and is not even compared.
+			/// Parameters passed in uniform buffer are just written to their slot, they do not
+			/// take re-recording.
+			template<class F, class... Arrs>
+			auto record(const void* params, std::size_t params_size
+			            , const void* dispatch_key, std::size_t dispatch_key_size
+			            , F&& record_end, Arrs&... arrs
+			            )-> void
+			{
+				const auto b = collect_bindings(arrs...);
+				_next_key.clear();
+				const auto n_list = _list_infos.size();
+				key_add(&n_list, sizeof(n_list));
+				key_add(&_dscslot, sizeof(_dscslot));
+				key_add(&b, sizeof(b));
+				key_add(_list_infos.data(), n_list*sizeof(vk::DescriptorBufferInfo));
+				key_add(_list_ids.data(), n_list*sizeof(uint64_t));
+				const auto n_bindings = _next_key.size();
+				key_add(&_pipeline, sizeof(_pipeline));
+				key_add(&_query_pool, sizeof(_query_pool));
+				const auto n_acquire = _acquire.size();
+				key_add(&n_acquire, sizeof(n_acquire));
+				for(const auto& a: _acquire){ // barriers have padding, add the fields that vary
+					key_add(&a.buffer, sizeof(a.buffer));
+					key_add(&a.offset, sizeof(a.offset));
+					key_add(&a.size, sizeof(a.size));
+				}
+				if(_params_ring){
+					write_params(params);
+					key_add(&_params_slot, sizeof(_params_slot));
+				} else {
+					key_add(params, params_size);
+				}
+				key_add(dispatch_key, dispatch_key_size);
+
+				const auto same_bindings = n_bindings <= _record_key.size()
+				                           && std::equal(begin(_next_key), begin(_next_key) + n_bindings
+				                                         , begin(_record_key));
+				if(_record_version == _device.computeCmdBufferVersion() && _next_key == _record_key){
+					_acquire.clear(); // acquired by the record as well
+					return; // buffer holds just that
+				}
+				_record_version = 0;
+				_record_key.clear(); // descriptor set is not known to be up to date till recorded
+				command_buffer_begin(b, layout_types<sizeof...(Arrs)>(), same_bindings);
+				record_params(params, params_size);
+				record_end();
+				_record_version = _device.computeCmdBufferVersion();
+				std::swap(_record_key, _next_key);
+			}
+
+			/// Check that the ownership transfers the run waits for are all recorded, that is
+			/// after() was not called past the bind.
+			/// @throws std::logic_error
+			auto check_acquired()-> void {
+				if(!_acquire.empty()){
+					_acquire.clear();
+					throw std::logic_error("buffer ownership transfer is not recorded"
+					                       ", after() should be called before the bind");
+				}
+			}
+
+			/// Record passing the parameters to the kernel (see record_begin()).
+			/// @pre command buffer should be in the recording state.
+			auto record_params(const void* params, std::size_t params_size)-> void {
+				if(_params_ring){
+					bind_params();
+				} else if(params_size > 0){
+					_device.computeCmdBuffer().pushConstants(_pipelayout, vk::ShaderStageFlagBits::eCompute
+					                                         , 0, uint32_t(params_size), params);
+				}
+			}
+
+			/// Append bytes to the key of the command buffer being recorded.
+			auto key_add(const void* data, std::size_t size)-> void {
+				const auto bytes = static_cast<const char*>(data);
+				_next_key.insert(end(_next_key), bytes, bytes + size);
 			}
 
 			/// Ends command buffer creation. Writes dispatch info and signals end of commands recording.
+			/// Dispatch is surrounded by timestamps if timing is on.
 			auto command_buffer_end()-> void {
 				auto cmdbuf = _device.computeCmdBuffer();
-				cmdbuf.dispatch(_batch[0], _batch[1], _batch[2]); // start compute pipeline, execute the shader
+				record_timestamp_start(cmdbuf);
+				record_dispatch({0, 0, 0}, _batch);
+				record_timestamp_end(cmdbuf);
 				cmdbuf.end(); // end recording commands
 			}
+
+			/// Record resetting the timestamps and writing the first one, if timing is on.
+			auto record_timestamp_start(vk::CommandBuffer cmdbuf)-> void {
+				if(_query_pool){
+					cmdbuf.resetQueryPool(_query_pool, 0, 2);
+					cmdbuf.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, _query_pool, 0);
+				}
+			}
+
+			/// Record writing the second timestamp, if timing is on.
+			auto record_timestamp_end(vk::CommandBuffer cmdbuf)-> void {
+				if(_query_pool){
+					cmdbuf.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, _query_pool, 1);
+				}
+			}
+
+			/// Ends command buffer creation with the indirect dispatch, grid dimensions are read
+			/// at execution time from the array of 3 uint32_t values (VkDispatchIndirectCommand).
+			/// Array may be written by the kernels run before in the same queue, dispatch and
+			/// the kernel itself are fenced against those by a barrier.
+			/// Dispatch is surrounded by timestamps if timing is on.
+			template<class Arr>
+			auto command_buffer_end_indirect(Arr& grid)-> void {
+				static_assert(std::is_same<typename Arr::value_type, uint32_t>::value
+				              , "indirect dispatch arguments should be the array of uint32_t");
+				auto cmdbuf = _device.computeCmdBuffer();
+				auto barrier = vk::MemoryBarrier(vk::AccessFlagBits::eShaderWrite
+				                                 , vk::AccessFlagBits::eIndirectCommandRead
+				                                   | vk::AccessFlagBits::eShaderRead);
+				cmdbuf.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader
+				                       , vk::PipelineStageFlagBits::eDrawIndirect
+				                         | vk::PipelineStageFlagBits::eComputeShader
+				                       , {}, 1, &barrier, 0, nullptr, 0, nullptr);
+				record_timestamp_start(cmdbuf);
+				cmdbuf.dispatchIndirect(grid.buffer(), vk::DeviceSize(grid.offset()*sizeof(uint32_t)));
+				record_timestamp_end(cmdbuf);
+				cmdbuf.end();
+			}
+
+			/// Record dispatch of the part of the grid starting at a given base (workgroups).
+			/// Grid exceeding device's maxComputeWorkGroupCount is split into several dispatches.
+			/// Dispatches with non-zero base are recorded with vkCmdDispatchBaseKHR, base is then
+			/// included in gl_WorkGroupID and gl_GlobalInvocationID seen by the kernel.
+			/// @throws vuh::ExtensionNotFound if non-zero base is needed and the device does not
+			/// support VK_KHR_device_group.
+			auto record_dispatch(const std::array<uint32_t, 3>& base
+			                     , const std::array<uint32_t, 3>& count
+			                     )-> void
+			{
+				auto cmdbuf = _device.computeCmdBuffer();
+				const auto& limits = _device.properties().limits.maxComputeWorkGroupCount;
+				if(base == std::array<uint32_t, 3>{{0, 0, 0}}
+				   && count[0] <= limits[0] && count[1] <= limits[1] && count[2] <= limits[2])
+				{
+					cmdbuf.dispatch(count[0], count[1], count[2]); // start compute pipeline, execute the shader
+					return;
+				}
+				if(!_device.supportsDispatchBase()){
+					throw ExtensionNotFound("VK_KHR_device_group is needed to split the grid "
+					                        "into several dispatches");
+				}
+				for(uint32_t z = 0; z < count[2]; z += std::min(count[2] - z, limits[2])){
+					for(uint32_t y = 0; y < count[1]; y += std::min(count[1] - y, limits[1])){
+						for(uint32_t x = 0; x < count[0]; x += std::min(count[0] - x, limits[0])){
+							_device.cmdDispatchBase(cmdbuf, {{base[0] + x, base[1] + y, base[2] + z}}
+							                        , {{std::min(count[0] - x, limits[0])
+							                          , std::min(count[1] - y, limits[1])
+							                          , std::min(count[2] - z, limits[2])}});
+						}
+					}
+				}
+			}
+
+			/// @return pipeline creation flags. Pipelines allow dispatches with non-zero base
+			/// whenever the device supports those.
+			auto pipeline_flags() const-> vk::PipelineCreateFlags {
+				return _device.supportsDispatchBase()
+				       ? vk::PipelineCreateFlags(vk::PipelineCreateFlagBits::eDispatchBaseKHR)
+				       : vk::PipelineCreateFlags();
+			}
+
+			/// Set the subgroup size the pipelines built from now on are required to run with.
+			/// @throws vuh::ExtensionNotFound if the device does not support
+			/// VK_EXT_subgroup_size_control for compute kernels.
+			/// @throws std::out_of_range if size is not a power of 2 within the device's
+			/// [min_subgroup_size, max_subgroup_size].
+			auto require_subgroup(uint32_t size)-> void {
+				const auto& f = _device.features();
+				if(!f.subgroup_size_control){
+					throw ExtensionNotFound("VK_EXT_subgroup_size_control");
+				}
+				if(size < f.min_subgroup_size || f.max_subgroup_size < size || (size & (size - 1))){
+					throw std::out_of_range("subgroup size is not supported by the device");
+				}
+				_required_subgroup = size;
+			}
+
+			/// Pass the subgroup size (see subgroup_size()) to the pipelines built from now on
+			/// as the specialization constant with a given id.
+			auto set_subgroup_size_id(uint32_t id)-> void { _subgroup_size_id = id; }
+
+			/// Set up the SPIR-V optimization of the kernel code (see vuh::optimize_spirv()).
+			/// Without freezing the code is optimized once right away. With freezing each pipeline
+			/// is built from the code optimized for its values of specialization constants.
+			/// Pipelines built (or being built) before keep the code they were built with.
+			/// Noop without SPIRV-Tools (see vuh::spirv_opt_supported()), pipelines are then built
+			/// from the original module.
+			auto set_optimization(SpirvOpt recipe, bool freeze_specs, const std::string& cache_dir
+			                      )-> void
+			{
+				if(!spirv_opt_supported()){
+					return;
+				}
+				_opt = recipe;
+				_opt_freeze = freeze_specs;
+				_opt_cache = cache_dir;
+				if(_code.empty()){ // embedded code is only copied when it is to be optimized
+					const auto bytes = reinterpret_cast<const char*>(_embedded);
+					_code.assign(bytes, bytes + _embedded_words*sizeof(uint32_t));
+				}
+				if(!freeze_specs){
+					const auto code = optimize_spirv(_code, recipe, nullptr, cache_dir
+					                                 , _device.apiVersion());
+					auto module = _device.sharedShaderModule(reinterpret_cast<const uint32_t*>(code.data())
+					                                         , code.size(), _shader_flags);
+					_device.releaseShared(_shader);
+					_shader = module;
+				}
+			}
+
+			/// Everything the pipeline is built from, captured by value so that the build may run
+			/// on a worker thread while the program itself is set up further.
+			struct PipelineRecipe {
+				vuh::Device* device;                             ///< device to build the pipeline on
+				vk::ShaderModule shader;                         ///< module the pipeline is built from unless the code is optimized per pipeline
+				vk::ShaderModuleCreateFlags shader_flags;        ///< flags of the modules made of the code optimized per pipeline
+				vk::PipelineLayout layout;                       ///< pipeline layout
+				std::vector<vk::SpecializationMapEntry> entries; ///< specialization constants map, including the subgroup size
+				std::vector<char> data;                          ///< specialization constants values
+				uint32_t required_subgroup;                      ///< required subgroup size, 0 if not required
+				std::vector<char> code;                          ///< code to optimize with frozen specialization constants, empty if not frozen
+				SpirvOpt opt;                                    ///< optimization recipe of the frozen code
+				std::string opt_cache;                           ///< directory of the optimized code cache
+				vk::PipelineCreateFlags flags;                   ///< pipeline creation flags
+				vk::Pipeline base;                               ///< base pipeline of the derivative one
+
+				/// Create the compute pipeline.
+				/// If specialization constants are to be frozen, the pipeline is built from the module
+				/// optimized for the constant values, which is released right after.
+				auto build() const-> vk::Pipeline {
+					auto specInfo = vk::SpecializationInfo(uint32_t(entries.size()), entries.data()
+					                                       , data.size(), data.data());
+					auto module = shader;
+					if(!code.empty()){
+						const auto frozen = optimize_spirv(code, opt, &specInfo, opt_cache
+						                                   , device->apiVersion());
+						module = device->createShaderModule({shader_flags, uint32_t(frozen.size())
+						                                    , reinterpret_cast<const uint32_t*>(frozen.data())});
+					}
+
+					// Specify the compute shader stage, and it's entry point (main), and specializations
+					auto stageCI = vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags()
+					                                                 , vk::ShaderStageFlagBits::eCompute
+					                                                 , module, "main", &specInfo);
+					auto requiredCI = vk::PipelineShaderStageRequiredSubgroupSizeCreateInfoEXT(
+					                                                                required_subgroup);
+					if(required_subgroup){
+						stageCI.pNext = &requiredCI;
+					}
+					auto r = vk::Pipeline{};
+					try {
+						r = device->createPipeline(layout, device->pipelineCache(), stageCI, flags, base);
+					} catch(...) {
+						if(module != shader){
+							device->destroyShaderModule(module);
+						}
+						throw;
+					}
+					if(module != shader){
+						device->destroyShaderModule(module);
+					}
+					return r;
+				}
+			}; // struct PipelineRecipe
+
+			/// @return recipe of the compute pipeline with given specialization constants.
+			/// Subgroup size (see subgroup_size()) is passed as one more constant if
+			/// set_subgroup_size_id() was called, and is required by the pipeline if
+			/// require_subgroup() was called.
+			/// @throws std::invalid_argument if the subgroup size constant id is taken by the
+			/// program's own constants.
+			auto pipeline_recipe(const vk::SpecializationMapEntry* entries, uint32_t n_entries
+			                     , const void* data, std::size_t data_size
+			                     , vk::PipelineCreateFlags flags, vk::Pipeline base={}
+			                     ) const-> PipelineRecipe
+			{
+				const auto pass_subgroup = _subgroup_size_id != no_subgroup_size_id;
+				auto r = PipelineRecipe{&_device, _shader, _shader_flags, _pipelayout
+				                       , std::vector<vk::SpecializationMapEntry>(entries, entries + n_entries)
+				                       , std::vector<char>(data_size + (pass_subgroup ? sizeof(uint32_t) : 0))
+				                       , _required_subgroup, {}, _opt, _opt_cache, flags, base};
+				if(data_size > 0){
+					std::memcpy(r.data.data(), data, data_size);
+				}
+				if(pass_subgroup){
+					if(std::any_of(entries, entries + n_entries
+					               , [this](const auto& e){ return e.constantID == _subgroup_size_id; }))
+					{
+						throw std::invalid_argument("subgroup size constant id is taken by the program's"
+						                            " specialization constants");
+					}
+					r.entries.emplace_back(_subgroup_size_id, uint32_t(data_size), sizeof(uint32_t));
+					const auto sg_size = subgroup_size();
+					std::memcpy(r.data.data() + data_size, &sg_size, sizeof(sg_size));
+				}
+				if(_opt_freeze){
+					r.code = _code;
+				}
+				return r;
+			}
+
+			/// Create the compute pipeline with given specialization constants (see pipeline_recipe()).
+			auto create_pipeline(const vk::SpecializationMapEntry* entries, uint32_t n_entries
+			                     , const void* data, std::size_t data_size
+			                     , vk::PipelineCreateFlags flags, vk::Pipeline base={}
+			                     )-> vk::Pipeline
+			{
+				return pipeline_recipe(entries, n_entries, data, data_size, flags, base).build();
+			}
+
+			/// Start building the pipeline on a worker thread.
+			/// @return future pipeline, build failure is rethrown when it is taken
+			static auto build_async(PipelineRecipe recipe)-> std::future<vk::Pipeline> {
+				return std::async(std::launch::async, [recipe]{ return recipe.build(); });
+			}
+
+			/// Wait for the pipeline being built on a worker thread and destroy it.
+			/// Failed builds are ignored.
+			auto discard(std::future<vk::Pipeline>& pending) noexcept-> void {
+				try {
+					_device.destroyPipeline(pending.get());
+				} catch(...) {}
+			}
+
+			/// @return grid size (workgroups) covering the given number of elements in 1D
+			/// @throws std::length_error if the grid size does not fit 32 bits
+			static auto grid_size(std::size_t n_elements, uint32_t workgroup_size)-> uint32_t {
+				assert(workgroup_size > 0);
+				const auto r = (n_elements + workgroup_size - 1)/workgroup_size;
+				if(r > std::size_t(uint32_t(-1))){
+					throw std::length_error("grid size does not fit 32 bits");
+				}
+				return uint32_t(r);
+			}
+
+			/// Run the grid as a sequence of slices, each submitted separately and waited for.
+			/// This leaves the gaps between slices for other work submitted to the compute queue,
+			/// so that one long kernel does not monopolize it.
+			/// Grid is sliced along its outermost non-trivial dimension, the slice size is adjusted
+			/// after each slice to make the slice run time close to the given budget.
+			/// Record function is called for each slice to begin the command buffer and record
+			/// everything up to the dispatch.
+			/// If timing is on, the first slice writes the first timestamp and the last slice
+			/// the second one.
+			/// @throws vuh::ExtensionNotFound if grid is split into more than one slice on a device
+			/// not supporting VK_KHR_device_group. Nothing is run then.
+			template<class F>
+			auto run_sliced(std::chrono::microseconds budget, F&& begin_slice)-> void {
+				using clock = std::chrono::steady_clock;
+				const auto dim = _batch[2] > 1 ? 2u : _batch[1] > 1 ? 1u : 0u;
+				const auto total = _batch[dim];
+				auto slice = std::max(1u, total/64); // start small, grow up to the budget
+				if(slice < total && !_device.supportsDispatchBase()){ // fail before the first slice runs
+					throw ExtensionNotFound("VK_KHR_device_group is needed to run the grid in slices");
+				}
+				for(uint32_t done = 0; done < total;){
+					auto base = std::array<uint32_t, 3>{{0, 0, 0}};
+					base[dim] = done;
+					auto count = _batch;
+					count[dim] = std::min(slice, total - done);
+					begin_slice();
+					auto cmdbuf = _device.computeCmdBuffer();
+					if(done == 0){
+						record_timestamp_start(cmdbuf);
+					}
+					record_dispatch(base, count);
+					if(done + count[dim] == total){
+						record_timestamp_end(cmdbuf);
+					}
+					cmdbuf.end();
+					const auto start = clock::now();
+					run();
+					const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+					                                                   clock::now() - start);
+					done += count[dim];
+					// rescale to the budget, but grow at most twice at a time to tolerate noise
+					const auto scaled = elapsed.count() > 0
+					                    ? double(count[dim])*double(budget.count())/double(elapsed.count())
+					                    : 2.0*count[dim];
+					slice = uint32_t(std::max(1.0, std::min(scaled, 2.0*count[dim])));
+				}
+			}
 		protected: // data
 			vk::ShaderModule _shader;            ///< compute shader to execute
 			vk::DescriptorSetLayout _dsclayout;  ///< descriptor set layout. This defines the kernel's array parameters interface.
-			vk::DescriptorPool _dscpool;         ///< descitptor ses pool. Descriptors are allocated on this pool.
-			vk::DescriptorSet _dscset;           ///< descriptors set
-			vk::PipelineCache _pipecache;        ///< pipeline cache
+			std::shared_ptr<DescriptorRing> _dscring; ///< descriptor sets to bind array parameters, recycled on completion of async runs (shared with those)
+			uint32_t _dscslot = DescriptorRing::no_slot; ///< id of the set in the ring the current parameters are bound to
+			bool _push_descriptors = false;      ///< true if array parameters are pushed to command buffer (VK_KHR_push_descriptor) instead of using descriptor sets
+			uint32_t _list_capacity = 0;         ///< number of descriptors reserved for the array list parameter, 0 if there is none
+			std::vector<vk::DescriptorType> _dsc_types; ///< descriptor types of the layout, as set up at the first bind
+			std::vector<vk::DescriptorBufferInfo> _list_infos; ///< descriptor infos of the currently bound array list elements
+			std::vector<uint64_t> _list_ids;     ///< ids of the currently bound array list elements
+			std::vector<vk::WriteDescriptorSet> _list_writes;  ///< descriptor writes of the array list elements (kept to reuse the storage)
+			std::shared_ptr<UniformRing> _params_ring; ///< uniform buffer slots to pass the parameters too large for push constants, null if those are pushed
+			uint32_t _params_slot = UniformRing::no_slot; ///< id of the slot in the ring the current parameters are written to
+			vk::QueryPool _query_pool;           ///< timestamps surrounding the dispatch, null if timing is off
+			std::vector<char> _record_key;       ///< state the device's compute command buffer was last recorded with by this program
+			std::vector<char> _next_key;         ///< state of the bind in progress (kept to reuse the storage)
+			uint64_t _record_version = 0;        ///< version of the device's compute command buffer holding the last record of this program, 0 if none
+			std::chrono::nanoseconds _spin{-1};  ///< time sync runs poll for completion before blocking, negative to use the device's setting
+			std::vector<TimelinePoint> _after;   ///< points on the device timelines the next run waits for
+			std::vector<vk::BufferMemoryBarrier> _acquire; ///< ownership transfers to the compute queue family the next record starts with, cleared once recorded
+			std::vector<char> _code;             ///< original kernel SPIR-V code, the optimization starts from (empty for the embedded code till it is optimized)
+			const uint32_t* _embedded = nullptr; ///< embedded kernel code the program was created from, not owned
+			std::size_t _embedded_words = 0;     ///< size of the embedded code (32-bit words)
+			vk::ShaderModuleCreateFlags _shader_flags; ///< flags the shader modules of the program are created with
+			SpirvOpt _opt = SpirvOpt::None;      ///< optimization recipe applied to the kernel code
+			bool _opt_freeze = false;            ///< true if specialization constants are frozen in optimized code of each pipeline
+			std::string _opt_cache;              ///< directory of the optimized code cache, empty if there is none
+			uint64_t _code_hash;                 ///< hash of the kernel SPIR-V code
+			uint32_t _required_subgroup = 0;     ///< subgroup size required for the pipelines, 0 if not required
+			uint32_t _subgroup_size_id = no_subgroup_size_id; ///< id of the specialization constant to pass the subgroup size with
 			vk::PipelineLayout _pipelayout;      ///< pipeline layout
 			mutable vk::Pipeline _pipeline;      ///< pipeline itself
 
@@ -291,37 +1418,184 @@ namespace vuh {
 		template<class Specs> class SpecsBase;
 
 		/// Explicit specialization for non-empty specialization constants interface.
+		/// Keeps the pipelines built for all specialization constants values (and required subgroup
+		/// sizes) used so far, so that switching between those does not trigger the pipeline rebuild.
+		/// The first specialization constant is taken for the workgroup size if it is of integral type.
 		template<template<class...> class Specs, class... Spec_Ts>
 		class SpecsBase<Specs<Spec_Ts...>>: public ProgramBase {
+			using Workgroup_t = std::tuple_element_t<0, std::tuple<Spec_Ts..., void>>;
+		public:
+			/// @return current values of specialization constants
+			auto specs() const-> const std::tuple<Spec_Ts...>& { return _specs; }
 		protected:
 			/// Construct object using given a vuh::Device and path to SPIR-V shader code.
 			SpecsBase(Device& device, const char* filepath, vk::ShaderModuleCreateFlags flags={})
 			   : ProgramBase(device, filepath, flags)
-			{}
+			{
+				apply_tuned(std::is_integral<Workgroup_t>{});
+			}
 
 			/// Construct object using given a vuh::Device a SPIR-V shader code.
 			SpecsBase(Device& device, const std::vector<char>& code, vk::ShaderModuleCreateFlags f={})
 			   : ProgramBase(device, code, f)
-			{}
+			{
+				apply_tuned(std::is_integral<Workgroup_t>{});
+			}
 
-			/// Initialize the pipeline.
-			/// Specialization constants interface is defined here.
+			/// Construct object using given a vuh::Device a SPIR-V shader code (32-bit words).
+			SpecsBase(Device& device, const uint32_t* code, std::size_t n_words
+			          , vk::ShaderModuleCreateFlags f={})
+			   : ProgramBase(device, code, n_words, f)
+			{
+				apply_tuned(std::is_integral<Workgroup_t>{});
+			}
+
+			/// Destroy all pipelines built for this program.
+			~SpecsBase() noexcept { release_pipelines(); }
+
+			SpecsBase(SpecsBase&&) = default;
+
+			/// Move assignment. Releases pipelines of the current instance before taking over those of the other.
+			SpecsBase& operator= (SpecsBase&& o) noexcept {
+				release_pipelines();
+				ProgramBase::operator=(std::move(o));
+				_specs = o._specs;
+				_pipelines = std::move(o._pipelines);
+				_pending = std::move(o._pending);
+				_pipeline_base = o._pipeline_base;
+				_derive = o._derive;
+				o._pipelines.clear();
+				o._pending.clear();
+				return *this;
+			}
+
+			/// Make the pipeline for current values of specialization constants the active one.
+			/// Pipeline is taken from the cache of previously built variants, or from the build
+			/// started by init_pipeline_async() (waiting for it if not ready yet), or created and cached.
+			/// With derivatives on (see set_derivatives()) variants built when some other is already
+			/// there are created as its derivatives.
 			auto init_pipeline()-> void {
+				const auto key = std::make_pair(_required_subgroup, _specs);
+				auto it = _pipelines.find(key);
+				if(it != _pipelines.end()){
+					_pipeline = it->second;
+					return;
+				}
+				auto pending = _pending.find(key);
+				if(pending != _pending.end()){
+					auto future = std::move(pending->second);
+					_pending.erase(pending);
+					add_pipeline(key, future.get());
+					return;
+				}
+				add_pipeline(key, recipe().build());
+			}
+
+			/// Start building the pipeline for current values of specialization constants on
+			/// a worker thread. Noop if such pipeline is already built or being built.
+			auto init_pipeline_async()-> void {
+				const auto key = std::make_pair(_required_subgroup, _specs);
+				if(_pipelines.count(key) == 0 && _pending.count(key) == 0){
+					_pending.emplace(key, build_async(recipe()));
+				}
+			}
+
+			/// Set up the SPIR-V optimization of the kernel code (see ProgramBase::set_optimization()).
+			/// Pipelines still being built may use the shader module that is replaced, so those
+			/// builds are waited for first.
+			auto set_optimization(SpirvOpt recipe, bool freeze_specs, const std::string& cache_dir
+			                      )-> void
+			{
+				for(auto& p: _pending){
+					p.second.wait();
+				}
+				ProgramBase::set_optimization(recipe, freeze_specs, cache_dir);
+			}
+
+			/// Build the pipeline variants as derivatives of the first one built.
+			/// Affects pipelines built after the call.
+			auto set_derivatives(bool on)-> void { _derive = on; }
+		private: // helpers
+			/// Set the workgroup size (the first specialization constant) to the value found in
+			/// the device's tuning database (see vuh::autotune()), if any.
+			auto apply_tuned(std::true_type)-> void {
+				const auto tuned = _device.tunedWorkgroupSize(_code_hash);
+				if(tuned > 0){
+					std::get<0>(_specs) = Workgroup_t(tuned);
+				}
+			}
+
+			auto apply_tuned(std::false_type)-> void {}
+
+			/// Check that the workgroup (the first specialization constant) fits the device's
+			/// maxComputeWorkgroupSubgroups subgroups of the required size.
+			/// @throws std::out_of_range
+			auto check_subgroups(std::true_type) const-> void {
+				const auto max_subgroups = _device.features().max_workgroup_subgroups;
+				if(_required_subgroup
+				   && std::size_t(std::get<0>(_specs)) > std::size_t(_required_subgroup)*max_subgroups)
+				{
+					throw std::out_of_range("workgroup takes more subgroups of the required size"
+					                        " than device supports (maxComputeWorkgroupSubgroups)");
+				}
+			}
+
+			auto check_subgroups(std::false_type) const-> void {}
+
+			/// @return recipe of the pipeline for current values of specialization constants,
+			/// a derivative of the base pipeline if derivatives are on and there is one already.
+			/// @throws std::out_of_range if the workgroup does not fit the required subgroup size
+			auto recipe() const-> PipelineRecipe {
+				check_subgroups(std::is_integral<Workgroup_t>{});
 				auto specEntries = specs2mapentries(_specs);
-				auto specInfo = vk::SpecializationInfo(uint32_t(specEntries.size()), specEntries.data()
-																	, sizeof(_specs), &_specs);
+				if(!_derive){
+					return pipeline_recipe(specEntries.data(), uint32_t(specEntries.size())
+					                       , &_specs, sizeof(_specs), pipeline_flags());
+				}
+				auto flags = pipeline_flags()
+				             | (_pipeline_base ? vk::PipelineCreateFlagBits::eDerivative
+				                               : vk::PipelineCreateFlagBits::eAllowDerivatives);
+				return pipeline_recipe(specEntries.data(), uint32_t(specEntries.size())
+				                       , &_specs, sizeof(_specs), flags, _pipeline_base);
+			}
+
+			/// Cache the built pipeline and make it the active one.
+			/// With derivatives on the first one becomes the base.
+			auto add_pipeline(const std::pair<uint32_t, std::tuple<Spec_Ts...>>& key
+			                  , vk::Pipeline pipeline
+			                  )-> void
+			{
+				_pipeline = pipeline;
+				if(_derive && !_pipeline_base){
+					_pipeline_base = _pipeline;
+				}
+				_pipelines.emplace(key, _pipeline);
+			}
 
-				// Specify the compute shader stage, and it's entry point (main), and specializations
-				auto stageCI = vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags()
-																				 , vk::ShaderStageFlagBits::eCompute
-																				 , _shader, "main", &specInfo);
-				_pipeline = _device.createPipeline(_pipelayout, _pipecache, stageCI);
+			/// Destroy all cached pipeline variants, wait for those still being built and destroy them too.
+			auto release_pipelines() noexcept-> void {
+				for(auto& p: _pending){
+					discard(p.second);
+				}
+				_pending.clear();
+				for(auto& p: _pipelines){
+					_device.destroyPipeline(p.second);
+				}
+				_pipelines.clear();
+				_pipeline = nullptr;
+				_pipeline_base = nullptr;
 			}
 		protected:
 			std::tuple<Spec_Ts...> _specs; ///< hold the state of specialization constants between call to specs() and actual pipeline creation
+		private:
+			std::map<std::pair<uint32_t, std::tuple<Spec_Ts...>>, vk::Pipeline> _pipelines; ///< pipelines built so far, keyed by required subgroup size and specialization constants values
+			std::map<std::pair<uint32_t, std::tuple<Spec_Ts...>>, std::future<vk::Pipeline>> _pending; ///< pipelines being built on worker threads
+			vk::Pipeline _pipeline_base;   ///< first pipeline built, the base for the derivative ones
+			bool _derive = false;          ///< build pipeline variants as derivatives of the base one
 		};
 
 		/// Explicit specialization for empty specialization constants interface.
+		/// Keeps the pipelines built for all required subgroup sizes used so far.
 		template<>
 		class SpecsBase<typelist<>>: public ProgramBase{
 		protected:
@@ -335,14 +1609,84 @@ namespace vuh {
 			   : ProgramBase(device, code, f)
 			{}
 
-			/// Initialize the pipeline with empty specialialization constants interface.
+			/// Construct object using given a vuh::Device a SPIR-V shader code (32-bit words).
+			SpecsBase(Device& device, const uint32_t* code, std::size_t n_words
+			          , vk::ShaderModuleCreateFlags f={})
+			   : ProgramBase(device, code, n_words, f)
+			{}
+
+			/// Destroy all pipelines built for this program.
+			~SpecsBase() noexcept { release_pipelines(); }
+
+			SpecsBase(SpecsBase&&) = default;
+
+			/// Move assignment. Releases pipelines of the current instance before taking over those of the other.
+			SpecsBase& operator= (SpecsBase&& o) noexcept {
+				release_pipelines();
+				ProgramBase::operator=(std::move(o));
+				_pipelines = std::move(o._pipelines);
+				_pending = std::move(o._pending);
+				o._pipelines.clear();
+				o._pending.clear();
+				return *this;
+			}
+
+			/// Make the pipeline for the current required subgroup size the active one.
+			/// Pipeline is taken from the previously built ones, or from the build started by
+			/// init_pipeline_async() (waiting for it if not ready yet), or created.
 			auto init_pipeline()-> void {
-				auto stageCI = vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags()
-																				 , vk::ShaderStageFlagBits::eCompute
-																				 , _shader, "main", nullptr);
+				auto it = _pipelines.find(_required_subgroup);
+				if(it != _pipelines.end()){
+					_pipeline = it->second;
+					return;
+				}
+				auto pending = _pending.find(_required_subgroup);
+				if(pending != _pending.end()){
+					auto future = std::move(pending->second);
+					_pending.erase(pending);
+					_pipeline = future.get();
+				} else {
+					_pipeline = create_pipeline(nullptr, 0, nullptr, 0, pipeline_flags());
+				}
+				_pipelines.emplace(_required_subgroup, _pipeline);
+			}
+
+			/// Start building the pipeline for the current required subgroup size on a worker thread.
+			/// Noop if such pipeline is already built or being built.
+			auto init_pipeline_async()-> void {
+				if(_pipelines.count(_required_subgroup) == 0 && _pending.count(_required_subgroup) == 0){
+					_pending.emplace(_required_subgroup
+					                 , build_async(pipeline_recipe(nullptr, 0, nullptr, 0, pipeline_flags())));
+				}
+			}
 
-				_pipeline = _device.createPipeline(_pipelayout, _pipecache, stageCI);
+			/// Set up the SPIR-V optimization of the kernel code (see ProgramBase::set_optimization()).
+			/// Pipelines still being built may use the shader module that is replaced, so those
+			/// builds are waited for first.
+			auto set_optimization(SpirvOpt recipe, bool freeze_specs, const std::string& cache_dir
+			                      )-> void
+			{
+				for(auto& p: _pending){
+					p.second.wait();
+				}
+				ProgramBase::set_optimization(recipe, freeze_specs, cache_dir);
+			}
+		private: // helpers
+			/// Destroy all pipelines, wait for those still being built and destroy them too.
+			auto release_pipelines() noexcept-> void {
+				for(auto& p: _pending){
+					discard(p.second);
+				}
+				_pending.clear();
+				for(auto& p: _pipelines){
+					_device.destroyPipeline(p.second);
+				}
+				_pipelines.clear();
+				_pipeline = nullptr;
 			}
+		private: // data
+			std::map<uint32_t, vk::Pipeline> _pipelines; ///< pipelines built so far, keyed by required subgroup size
+			std::map<uint32_t, std::future<vk::Pipeline>> _pending; ///< pipelines being built on worker threads
 		}; // class SpecsBase
 	} // namespace detail
 
@@ -356,13 +1700,22 @@ namespace vuh {
 	template<class Specs=typelist<>, class Params=typelist<>> class Program;
 
 	/// Specialization with non-empty specialization constants and push constants.
+	/// Params larger than max_push_constants_size (the push constants size every device supports)
+	/// are passed in a uniform buffer instead, bound to binding 0 of descriptor set 1 with the std140
+	/// layout. Each invocation gets a slot of its own, so async runs do not overwrite the parameters
+	/// of each other.
 	template<template<class...> class Specs, class... Specs_Ts , class Params>
 	class Program<Specs<Specs_Ts...>, Params>: public detail::SpecsBase<Specs<Specs_Ts...>> {
 		using Base = detail::SpecsBase<Specs<Specs_Ts...>>;
 	public:
+		/// True if parameters are passed in uniform buffer rather than in push constants
+		static constexpr bool params_in_uniform = sizeof(Params) > Base::max_push_constants_size;
+		static_assert(sizeof(Params) <= 16384
+		              , "parameters should fit maxUniformBufferRange guaranteed by every device");
+
 		/// Initialize program on a device using SPIR-V code at a given path
 		Program(vuh::Device& device, const char* filepath, vk::ShaderModuleCreateFlags flags={})
-		   : Base(device, read_spirv(filepath), flags)
+		   : Base(device, filepath, flags)
 		{}
 
 		/// Initialize program on a device from binary SPIR-V code
@@ -372,6 +1725,13 @@ namespace vuh {
 		   : Base(device, code, flags)
 		{}
 
+		/// Initialize program on a device from SPIR-V code embedded in the executable
+		/// (see VARIABLE argument of vuh_compile_shader()).
+		template<std::size_t N>
+		Program(vuh::Device& device, const uint32_t (&code)[N], vk::ShaderModuleCreateFlags flags={})
+		   : Base(device, code, N, flags)
+		{}
+
 		using Base::run;
 		using Base::run_async;
 
@@ -383,24 +1743,96 @@ namespace vuh {
 			return *this;
 		}
 
+		/// Specify 1D running batch size covering a given number of elements.
+		/// Grid exceeding device's maxComputeWorkGroupCount is split into several dispatches
+		/// with base offsets at run time (VK_KHR_device_group is then required).
+		auto grid_for(std::size_t n_elements, uint32_t workgroup_size)-> Program& {
+			Base::_batch = {Base::grid_size(n_elements, workgroup_size), 1, 1};
+			return *this;
+		}
+
 		/// Specify values of specification constants.
 		auto spec(Specs_Ts... specs)-> Program& {
 			Base::_specs = std::make_tuple(specs...);
 			return *this;
 		}
 
+		/// Make the next run start after the operation behind a given token completes,
+		/// waiting on the device if it supports timeline semaphores (see ProgramBase::wait_for()).
+		/// Like program.after(copy_token).run_async(params, d_y, d_x).
+		template<class Action>
+		auto after(Delayed<Action>& token)-> Program& {
+			Base::wait_for(token);
+			return *this;
+		}
+
+		/// Require the kernel to run with subgroups of a given size (VK_EXT_subgroup_size_control).
+		/// Takes effect at the next bind.
+		/// @throws vuh::ExtensionNotFound if the device does not support required subgroup size
+		/// @throws std::out_of_range if the size is out of the device supported range
+		auto require_subgroup_size(uint32_t size)-> Program& {
+			Base::require_subgroup(size);
+			return *this;
+		}
+
+		/// Pass the subgroup size (the required one, or the device's) to the kernel as
+		/// the specialization constant with a given id. Takes effect at the next bind.
+		/// Binding throws std::invalid_argument if the id is taken by the program's own constants.
+		auto spec_subgroup_size(uint32_t id=vuh::subgroup_size_id)-> Program& {
+			Base::set_subgroup_size_id(id);
+			return *this;
+		}
+
+		/// Build the variants for other specialization constants values as derivatives of the
+		/// first pipeline built (off by default). May speed up the builds on drivers making use
+		/// of the base pipeline. Should be called before the first bind (or prepare_async()).
+		auto derive_pipelines(bool on=true)-> Program& {
+			Base::set_derivatives(on);
+			return *this;
+		}
+
+		/// Optimize the kernel code with a given SPIRV-Tools recipe (see vuh::optimize_spirv()).
+		/// With freeze_specs on, specialization constants are also frozen to their values in code
+		/// optimized separately for each set of values. That helps the drivers doing little
+		/// optimization of their own (e.g. software ones) at the cost of slower pipeline builds.
+		/// Optimized code is cached in the directory if one is given.
+		/// Should be called before the first bind (or prepare_async()), pipelines built before keep their code.
+		/// Code is used as is if vuh is built without SPIRV-Tools.
+		auto optimize(SpirvOpt recipe, bool freeze_specs=false, const std::string& cache_dir={}
+		              )-> Program&
+		{
+			Base::set_optimization(recipe, freeze_specs, cache_dir);
+			return *this;
+		}
+
+		/// Start building the pipeline for current specialization constants (and required subgroup
+		/// size) on a worker thread, so that the bind using those does not have to wait for it,
+		/// or waits less. Arrays declare the kernel interface the way the first bind() does,
+		/// their content is not used.
+		/// Several programs may be prepared at once with vuh::prepare_all().
+		template<class... Arrs>
+		auto prepare_async(Arrs&&... args)-> Program& {
+			if(!Base::_pipelayout){ // handle multiple rebind
+				init_pipelayout(args...);
+				Base::alloc_descriptor_sets(args...);
+			}
+			Base::init_pipeline_async();
+			return *this;
+		}
+
 		/// Associate buffers to binding points, and pushes the push constants.
 		/// Does most of setup here. Program is ready to be run.
 		/// @pre Grid dimensions and specialization constants (if applicable)
 		/// should be specified before calling this.
 		template<class... Arrs>
 		auto bind(const Params& p, Arrs&&... args)-> const Program& {
-			if(!Base::_pipeline){ // handle multiple rebind
+			if(!Base::_pipelayout){ // handle multiple rebind
 				init_pipelayout(args...);
 				Base::alloc_descriptor_sets(args...);
-				Base::init_pipeline();
 			}
-			create_command_buffer(p, args...);
+			Base::init_pipeline(); // pick (or build) the pipeline for current specialization constants
+			Base::record(&p, sizeof(p), &Base::_batch, sizeof(Base::_batch)
+			             , [this]{ Base::command_buffer_end(); }, args...);
 			return *this;
 		}
 
@@ -428,24 +1860,71 @@ namespace vuh {
 			bind(params, args...);
 			return Base::run_async();
 		}
+
+		/// Associate buffers to binding points and push the push constants like bind() does,
+		/// but take the grid dimensions from the device array at execution time.
+		/// Grid array may be passed among the array parameters as well.
+		template<class Arr, class... Arrs>
+		auto bind_indirect(Arr& grid, const Params& p, Arrs&&... args)-> const Program& {
+			if(!Base::_pipelayout){ // handle multiple rebind
+				init_pipelayout(args...);
+				Base::alloc_descriptor_sets(args...);
+			}
+			Base::init_pipeline();
+			const auto grid_key = std::make_pair(VkBuffer(grid.buffer()), vk::DeviceSize(grid.offset()));
+			Base::record(&p, sizeof(p), &grid_key, sizeof(grid_key)
+			             , [&]{ Base::command_buffer_end_indirect(grid); }, args...);
+			return *this;
+		}
+
+		/// Run program with the grid dimensions taken from the device array (indirect dispatch),
+		/// wait for completion.
+		/// Grid array holds 3 uint32_t values and may be written by the kernel run before,
+		/// so the chained stages do not need a round trip to host to set up the grid.
+		/// It should be created with vk::BufferUsageFlagBits::eIndirectBuffer usage.
+		template<class Arr, class... Arrs>
+		auto run_indirect(Arr& grid, const Params& params, Arrs&&... args)-> void {
+			bind_indirect(grid, params, args...);
+			Base::run();
+		}
+
+		/// Initiate execution of the program with the grid dimensions taken from the device array
+		/// and immidiately return.
+		/// @return Delayed<Compute> object for synchronization with host.
+		template<class Arr, class... Arrs>
+		auto run_indirect_async(Arr& grid, const Params& params, Arrs&&... args
+		                        )-> vuh::Delayed<detail::Compute>
+		{
+			bind_indirect(grid, params, args...);
+			return Base::run_async();
+		}
+
+		/// Run program with provided parameters as a sequence of slices of the grid, each taking
+		/// roughly the given time, and wait for completion.
+		/// Other work submitted to the compute queue may run in between the slices.
+		/// @pre grid dimensions should be specified before calling this.
+		template<class... Arrs>
+		auto run_sliced(std::chrono::microseconds budget, const Params& params, Arrs&&... args)-> void {
+			if(!Base::_pipelayout){ // handle multiple rebind
+				init_pipelayout(args...);
+				Base::alloc_descriptor_sets(args...);
+			}
+			Base::init_pipeline();
+			Base::run_sliced(budget, [&](){ Base::record_begin(&params, sizeof(params), args...); });
+		}
 	private: // helpers
 		/// Set up the state of the kernel that depends on number and types of bound array parameters.
 		/// Initizalizes the pipeline layout, declares the push constants interface.
 		template<class... Arrs>
 		auto init_pipelayout(Arrs&... args)-> void {
-			auto psranges = std::array<vk::PushConstantRange, 1>{{
-					vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(Params))}};
-			Base::init_pipelayout(psranges, args...);
-		}
-
-		/// Populate the associated device's compute command buffer.
-		/// Binds the descriptors and pushes the push constants.
-		template<class... Arrs>
-		auto create_command_buffer(const Params& p, Arrs&... args)-> void {
-			Base::command_buffer_begin(args...);
-			Base::_device.computeCmdBuffer().pushConstants(Base::_pipelayout
-			                           , vk::ShaderStageFlagBits::eCompute , 0, sizeof(p), &p);
-			Base::command_buffer_end();
+			if(params_in_uniform){
+				Base::init_params_ring(sizeof(Params));
+				Base::init_pipelayout(std::array<vk::PushConstantRange, 0>{}, args...);
+			} else {
+				auto psranges = std::array<vk::PushConstantRange, 1>{{
+				        vk::PushConstantRange(vk::ShaderStageFlagBits::eCompute, 0, sizeof(Params))}};
+				Base::init_pipelayout(psranges, args...);
+			}
 		}
 	}; // class Program
 
@@ -466,6 +1945,13 @@ namespace vuh {
 		   : Base (device, code, flags)
 		{}
 
+		/// Initialize program on a device from SPIR-V code embedded in the executable
+		/// (see VARIABLE argument of vuh_compile_shader()).
+		template<std::size_t N>
+		Program(vuh::Device& device, const uint32_t (&code)[N], vk::ShaderModuleCreateFlags flags={})
+		   : Base(device, code, N, flags)
+		{}
+
 		using Base::run;
 		using Base::run_async;
 
@@ -477,25 +1963,96 @@ namespace vuh {
 			return *this;
 		}
 
+		/// Specify 1D running batch size covering a given number of elements.
+		/// Grid exceeding device's maxComputeWorkGroupCount is split into several dispatches
+		/// with base offsets at run time (VK_KHR_device_group is then required).
+		auto grid_for(std::size_t n_elements, uint32_t workgroup_size)-> Program& {
+			Base::_batch = {Base::grid_size(n_elements, workgroup_size), 1, 1};
+			return *this;
+		}
+
 		/// Specify values of specification constants.
 		auto spec(Specs_Ts... specs)-> Program& {
 			Base::_specs = std::make_tuple(specs...);
 			return *this;
 		}
 
+		/// Make the next run start after the operation behind a given token completes,
+		/// waiting on the device if it supports timeline semaphores (see ProgramBase::wait_for()).
+		/// Like program.after(copy_token).run_async(params, d_y, d_x).
+		template<class Action>
+		auto after(Delayed<Action>& token)-> Program& {
+			Base::wait_for(token);
+			return *this;
+		}
+
+		/// Require the kernel to run with subgroups of a given size (VK_EXT_subgroup_size_control).
+		/// Takes effect at the next bind.
+		/// @throws vuh::ExtensionNotFound if the device does not support required subgroup size
+		/// @throws std::out_of_range if the size is out of the device supported range
+		auto require_subgroup_size(uint32_t size)-> Program& {
+			Base::require_subgroup(size);
+			return *this;
+		}
+
+		/// Pass the subgroup size (the required one, or the device's) to the kernel as
+		/// the specialization constant with a given id. Takes effect at the next bind.
+		/// Binding throws std::invalid_argument if the id is taken by the program's own constants.
+		auto spec_subgroup_size(uint32_t id=vuh::subgroup_size_id)-> Program& {
+			Base::set_subgroup_size_id(id);
+			return *this;
+		}
+
+		/// Build the variants for other specialization constants values as derivatives of the
+		/// first pipeline built (off by default). May speed up the builds on drivers making use
+		/// of the base pipeline. Should be called before the first bind (or prepare_async()).
+		auto derive_pipelines(bool on=true)-> Program& {
+			Base::set_derivatives(on);
+			return *this;
+		}
+
+		/// Optimize the kernel code with a given SPIRV-Tools recipe (see vuh::optimize_spirv()).
+		/// With freeze_specs on, specialization constants are also frozen to their values in code
+		/// optimized separately for each set of values. That helps the drivers doing little
+		/// optimization of their own (e.g. software ones) at the cost of slower pipeline builds.
+		/// Optimized code is cached in the directory if one is given.
+		/// Should be called before the first bind (or prepare_async()), pipelines built before keep their code.
+		/// Code is used as is if vuh is built without SPIRV-Tools.
+		auto optimize(SpirvOpt recipe, bool freeze_specs=false, const std::string& cache_dir={}
+		              )-> Program&
+		{
+			Base::set_optimization(recipe, freeze_specs, cache_dir);
+			return *this;
+		}
+
+		/// Start building the pipeline for current specialization constants (and required subgroup
+		/// size) on a worker thread, so that the bind using those does not have to wait for it,
+		/// or waits less. Arrays declare the kernel interface the way the first bind() does,
+		/// their content is not used.
+		/// Several programs may be prepared at once with vuh::prepare_all().
+		template<class... Arrs>
+		auto prepare_async(Arrs&&... args)-> Program& {
+			if(!Base::_pipelayout){ // handle multiple rebind
+				Base::init_pipelayout(std::array<vk::PushConstantRange, 0>{}, args...);
+				Base::alloc_descriptor_sets(args...);
+			}
+			Base::init_pipeline_async();
+			return *this;
+		}
+
 		/// Associate buffers to binding points, and pushes the push constants.
 		/// Does most of setup here. Program is ready to be run.
 		/// @pre Grid dimensions and specialization constants (if applicable)
 		/// should be specified before calling this.
 		template<class... Arrs>
 		auto bind(Arrs&&... args)-> const Program& {
-			if(!Base::_pipeline){ // handle multiple rebind
+			if(!Base::_pipelayout){ // handle multiple rebind
 				Base::init_pipelayout(std::array<vk::PushConstantRange, 0>{}, args...);
 				Base::alloc_descriptor_sets(args...);
-				Base::init_pipeline();
 			}
-			Base::command_buffer_begin(args...);
-			Base::command_buffer_end();
+			Base::init_pipeline(); // pick (or build) the pipeline for current specialization constants
+			Base::record(nullptr, 0, &Base::_batch, sizeof(Base::_batch)
+			             , [this]{ Base::command_buffer_end(); }, args...);
 			return *this;
 		}
 
@@ -515,5 +2072,69 @@ namespace vuh {
 			bind(args...);
 			return Base::run_async();
 		}
+
+		/// Associate buffers to binding points like bind() does, but take the grid dimensions
+		/// from the device array at execution time.
+		/// Grid array may be passed among the array parameters as well.
+		template<class Arr, class... Arrs>
+		auto bind_indirect(Arr& grid, Arrs&&... args)-> const Program& {
+			if(!Base::_pipelayout){ // handle multiple rebind
+				Base::init_pipelayout(std::array<vk::PushConstantRange, 0>{}, args...);
+				Base::alloc_descriptor_sets(args...);
+			}
+			Base::init_pipeline();
+			const auto grid_key = std::make_pair(VkBuffer(grid.buffer()), vk::DeviceSize(grid.offset()));
+			Base::record(nullptr, 0, &grid_key, sizeof(grid_key)
+			             , [&]{ Base::command_buffer_end_indirect(grid); }, args...);
+			return *this;
+		}
+
+		/// Run program with the grid dimensions taken from the device array (indirect dispatch),
+		/// wait for completion.
+		template<class Arr, class... Arrs>
+		auto run_indirect(Arr& grid, Arrs&&... args)-> void {
+			bind_indirect(grid, args...);
+			Base::run();
+		}
+
+		/// Initiate execution of the program with the grid dimensions taken from the device array
+		/// and immidiately return.
+		/// @return Delayed<Compute> object for synchronization with host.
+		template<class Arr, class... Arrs>
+		auto run_indirect_async(Arr& grid, Arrs&&... args)-> vuh::Delayed<detail::Compute> {
+			bind_indirect(grid, args...);
+			return Base::run_async();
+		}
+
+		/// Run program with provided parameters as a sequence of slices of the grid, each taking
+		/// roughly the given time, and wait for completion.
+		/// Other work submitted to the compute queue may run in between the slices.
+		/// @pre grid dimensions should be specified before calling this.
+		template<class... Arrs>
+		auto run_sliced(std::chrono::microseconds budget, Arrs&&... args)-> void {
+			if(!Base::_pipelayout){ // handle multiple rebind
+				Base::init_pipelayout(std::array<vk::PushConstantRange, 0>{}, args...);
+				Base::alloc_descriptor_sets(args...);
+			}
+			Base::init_pipeline();
+			Base::run_sliced(budget, [&](){ Base::command_buffer_begin(args...); });
+		}
 	}; // class Program
+
+	namespace detail {
+		// helper
+		template<class Tuple, size_t... I>
+		auto prepare_tied(const Tuple& prep, std::index_sequence<I...>)-> void {
+			std::get<0>(prep).prepare_async(std::get<I + 1>(prep)...);
+		}
+	} // namespace detail
+
+	/// Start building pipelines of several programs at once, each on a worker thread of its own
+	/// (see Program::prepare_async()).
+	/// Each argument ties the program with its array arguments, like std::tie(program, arrays...).
+	template<class... Preps>
+	auto prepare_all(const Preps&... preps)-> void {
+		(void)std::initializer_list<int>{0, (detail::prepare_tied(preps
+		                    , std::make_index_sequence<std::tuple_size<Preps>::value - 1>{}), 0)...};
+	}
 } // namespace vuh
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <vuh/arr/allocDevice.hpp>
+#include <vuh/arr/hostArray.hpp>
+#include <vuh/device.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace vuh {
+namespace detail {
+	/// Growable ring of fixed-size slots in persistently mapped host-visible memory, bound to
+	/// kernels as a dynamic uniform buffer.
+	/// Used to pass the kernel parameter blocks too large for push constants.
+	/// Each invocation writes its parameters to a slot of its own and binds the (never updated)
+	/// descriptor set of the slot's chunk with the slot offset as the dynamic offset.
+	/// As with DescriptorRing slots are handed out one at a time and marked busy till explicitly
+	/// freed, which normally happens when the async operation reading the slot completes.
+	/// Slots are allocated in chunks, each chunk with its own buffer and descriptor set.
+	/// Acquiring slots is not thread-safe, while freeing them is.
+	class UniformRing {
+	public:
+		static constexpr uint32_t chunk_size = 8;         ///< number of slots allocated at once
+		static constexpr uint32_t no_slot = uint32_t(-1); ///< denotes invalid slot id
+
+		/// Constructs empty ring. No slots can be acquired from that.
+		UniformRing() = default;
+
+		/// Constructor. Creates the descriptor set layout with a single dynamic uniform buffer
+		/// binding. Slots will hold a given number of bytes each.
+		UniformRing(vuh::Device& device, std::size_t slot_size)
+		   : _device(&device)
+		   , _size(slot_size)
+		   , _stride(aligned_stride(device, slot_size))
+		{
+			auto binding = vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBufferDynamic
+			                                              , 1, vk::ShaderStageFlagBits::eCompute);
+			_layout = device.createDescriptorSetLayout({vk::DescriptorSetLayoutCreateFlags()
+			                                           , 1, &binding});
+		}
+
+		/// Destroy all chunks and the descriptor set layout.
+		~UniformRing() noexcept { release(); }
+
+		UniformRing(const UniformRing&) = delete;
+		auto operator= (const UniformRing&)-> UniformRing& = delete;
+
+		/// Move constructor.
+		UniformRing(UniformRing&& o) noexcept
+		   : _device(o._device)
+		   , _layout(o._layout)
+		   , _size(o._size)
+		   , _stride(o._stride)
+		   , _chunks(std::move(o._chunks))
+		{
+			o._layout = nullptr;
+			o._chunks.clear();
+		}
+
+		/// Move assignment. Releases own resources before taking over those of the other object.
+		auto operator= (UniformRing&& o) noexcept-> UniformRing& {
+			release();
+			_device = o._device;
+			_layout = o._layout;
+			_size = o._size;
+			_stride = o._stride;
+			_chunks = std::move(o._chunks);
+			o._layout = nullptr;
+			o._chunks.clear();
+			return *this;
+		}
+
+		/// @return true if the ring was initialized (and slots can be acquired from it)
+		explicit operator bool() const { return bool(_layout); }
+
+		/// @return layout of the descriptor sets slots are bound with
+		auto layout() const-> vk::DescriptorSetLayout { return _layout; }
+
+		/// Find the free slot and mark it busy. Allocates a new chunk of slots if all are busy.
+		/// @return id of the acquired slot
+		auto acquire()-> uint32_t {
+			assert(_layout);
+			for(uint32_t i = 0; i < uint32_t(_chunks.size()); ++i){
+				for(uint32_t j = 0; j < chunk_size; ++j){
+					auto& busy = _chunks[i].busy[j];
+					if(!busy.load(std::memory_order_acquire)){
+						busy.store(true, std::memory_order_relaxed);
+						return i*chunk_size + j;
+					}
+				}
+			}
+			add_chunk();
+			_chunks.back().busy[0].store(true, std::memory_order_relaxed);
+			return uint32_t(_chunks.size() - 1)*chunk_size;
+		}
+
+		/// Copy data to the slot with a given id. Data size should be the slot size.
+		auto write(uint32_t id, const void* data)-> void {
+			std::memcpy(_chunks[id/chunk_size].array->data() + offset(id), data, _size);
+		}
+
+		/// @return descriptor set to bind the slot with a given id
+		auto set(uint32_t id) const-> vk::DescriptorSet { return _chunks[id/chunk_size].set; }
+
+		/// @return dynamic offset (bytes) of the slot with a given id
+		auto offset(uint32_t id) const-> uint32_t { return (id%chunk_size)*_stride; }
+
+		/// @return the busy flag of a slot with a given id.
+		/// Storing false to that frees the slot. The flag location is stable for the whole lifetime
+		/// of the ring.
+		auto busy_flag(uint32_t id)-> std::atomic<bool>* {
+			return &_chunks[id/chunk_size].busy[id%chunk_size];
+		}
+	private: // helpers
+		using Array = arr::HostArray<unsigned char, arr::AllocDevice<arr::properties::HostCoherent>>;
+
+		/// Chunk of slots sharing a buffer and a descriptor set.
+		struct Chunk {
+			std::unique_ptr<Array> array;              ///< mapped buffer holding the slots
+			vk::DescriptorPool pool;                   ///< pool the set is allocated from
+			vk::DescriptorSet set;                     ///< set referring to the chunk buffer
+			std::unique_ptr<std::atomic<bool>[]> busy; ///< in-use flags of the slots
+		};
+
+		/// @return distance (bytes) between the slots, that is the slot size rounded up
+		/// to the device's minUniformBufferOffsetAlignment
+		static auto aligned_stride(const vuh::Device& device, std::size_t size)-> uint32_t {
+			const auto alignment = std::size_t(device.properties().limits.minUniformBufferOffsetAlignment);
+			return uint32_t((size + alignment - 1)/alignment*alignment);
+		}
+
+		/// Allocate a new chunk of slots.
+		auto add_chunk()-> void {
+			auto chunk = Chunk{};
+			chunk.array = std::make_unique<Array>(*_device, std::size_t(_stride)*chunk_size
+			                                      , vk::MemoryPropertyFlags{}
+			                                      , vk::BufferUsageFlagBits::eUniformBuffer);
+			auto size = vk::DescriptorPoolSize(vk::DescriptorType::eUniformBufferDynamic, 1);
+			chunk.pool = _device->createDescriptorPool({vk::DescriptorPoolCreateFlags(), 1, 1, &size});
+			chunk.set = _device->allocateDescriptorSets({chunk.pool, 1, &_layout})[0];
+			auto info = vk::DescriptorBufferInfo(*chunk.array, 0, _size);
+			auto write = vk::WriteDescriptorSet(chunk.set, 0, 0, 1
+			                                    , vk::DescriptorType::eUniformBufferDynamic
+			                                    , nullptr, &info);
+			_device->updateDescriptorSets(1, &write, 0, nullptr);
+			chunk.busy.reset(new std::atomic<bool>[chunk_size]);
+			for(uint32_t i = 0; i < chunk_size; ++i){
+				chunk.busy[i].store(false, std::memory_order_relaxed);
+			}
+			_chunks.push_back(std::move(chunk));
+		}
+
+		/// Release chunks and the descriptor set layout.
+		auto release() noexcept-> void {
+			for(auto& c: _chunks){
+				_device->destroyDescriptorPool(c.pool);
+			}
+			_chunks.clear();
+			if(_layout){
+				_device->destroyDescriptorSetLayout(_layout);
+				_layout = nullptr;
+			}
+		}
+	private: // data
+		vuh::Device* _device = nullptr; ///< device slots are allocated on
+		vk::DescriptorSetLayout _layout; ///< layout of the sets binding the slots
+		std::size_t _size = 0;          ///< size (bytes) of the data in a slot
+		uint32_t _stride = 0;           ///< distance (bytes) between the slots
+		std::vector<Chunk> _chunks;     ///< allocated chunks of slots
+	}; // class UniformRing
+} // namespace detail
+} // namespace vuh
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -10,6 +12,25 @@ namespace vuh {
 	/// @return nearest integer bigger or equal to exact division value
 	inline auto div_up(uint32_t x, uint32_t y){ return (x + y - 1u)/y; }
 
+	/// @return 64-bit FNV-1a hash of a memory chunk.
+	/// Used to content-address cached binary data (pipeline caches, shader code, etc...).
+	inline auto hash_bytes(const void* data, std::size_t size_bytes
+	                       , uint64_t seed=0xcbf29ce484222325ull)-> uint64_t
+	{
+		auto p = static_cast<const unsigned char*>(data);
+		for(std::size_t i = 0; i < size_bytes; ++i){
+			seed = (seed ^ p[i])*0x100000001b3ull;
+		}
+		return seed;
+	}
+
+	/// @return number unique within the process. Tells apart the resources which may be given
+	/// the same Vulkan handles (after one is destroyed and the other created).
+	inline auto unique_id()-> uint64_t {
+		static std::atomic<uint64_t> counter{0};
+		return ++counter;
+	}
+
 	auto read_spirv(const char* filename)-> std::vector<char>;
 
 } // namespace vuh
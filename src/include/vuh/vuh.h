@@ -2,6 +2,8 @@
 
 #include "device.h"
 #include "error.h"
+#include "glsl.h"
 #include "instance.h"
+#include "optimize.h"
 #include "program.hpp"
 #include "utils.h"
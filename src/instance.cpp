@@ -15,6 +15,11 @@ namespace {
 	static const std::array<const char*, 0> default_layers = {};
 	static const std::array<const char*, 0> default_extensions = {};
 #endif
+	/// Extensions enabled when available as they are needed for some optional features
+	static const std::array<const char*, 2> optional_extensions = {
+		"VK_KHR_get_physical_device_properties2"
+	  , "VK_KHR_device_group_creation" // required by VK_KHR_device_group
+	};
 
 	/// Filter requested layers, throw away those not present on particular instance.
 	/// Add default validation layers to debug build.
@@ -52,7 +57,15 @@ namespace {
 		
 		if (all_required && extensions.size() != (r.size() - extensions.size()))
 			find_missing_and_throw<vuh::ExtensionNotFound>(extensions, r);
-			
+
+		// add optional extensions (unless explicitly requested already)
+		for(auto e: optional_extensions){
+			if(!contains(e, r, [](const char* s){ return s; })
+			   && contains(e, avail_extensions, [](const auto& l){ return l.extensionName; }))
+			{
+				r.push_back(e);
+			}
+		}
 		return r;
 	}
 
@@ -68,13 +81,29 @@ namespace {
 	   return VK_FALSE;
 	}
 
+	/// @return the requested API version clamped to what the loader supports.
+	/// Vulkan 1.0 loaders do not know vkEnumerateInstanceVersion and fail to create instances
+	/// asking for any version above 1.0.
+	auto supported_api_version(uint32_t requested)-> uint32_t {
+		auto fn = PFN_vkEnumerateInstanceVersion(
+		                        vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion"));
+		auto loader_version = uint32_t(VK_API_VERSION_1_0);
+		if(fn && fn(&loader_version) != VK_SUCCESS){
+			loader_version = VK_API_VERSION_1_0;
+		}
+		return std::max(uint32_t(VK_API_VERSION_1_0), std::min(requested, loader_version));
+	}
+
 	/// Create vulkan Instance with app specific parameters.
 	auto createInstance(const std::vector<const char*> layers
 	                   , const std::vector<const char*> extensions
 	                   , const vk::ApplicationInfo& info
+	                   , uint32_t api_version ///< API version to request instead of the one in info
 	                   )-> vk::Instance
 	{
-		auto createInfo = vk::InstanceCreateInfo(vk::InstanceCreateFlags(), &info
+		auto app_info = info;
+		app_info.apiVersion = api_version;
+		auto createInfo = vk::InstanceCreateInfo(vk::InstanceCreateFlags(), &app_info
 		                                         , ARR_VIEW(layers), ARR_VIEW(extensions));
 		return vk::createInstance(createInfo);
 	}
@@ -111,6 +140,7 @@ namespace {
 namespace vuh {
 	/// Creates Instance object.
 	/// In debug build in addition to user-defined layers attempts to load validation layers.
+	/// API version requested in info is lowered to the one supported by the loader.
 	Instance::Instance(const std::vector<const char*>& layers
 	                   , const std::vector<const char*>& extensions
 	                   , const vk::ApplicationInfo& info
@@ -118,7 +148,8 @@ namespace vuh {
 	                   )
 	   : _layers(filter_layers(layers))
 	   , _extensions(filter_extensions(extensions))
-	   , _instance(createInstance(_layers, _extensions, info))
+	   , _api_version(supported_api_version(info.apiVersion))
+	   , _instance(createInstance(_layers, _extensions, info, _api_version))
 	   , _reporter(report_callback ? report_callback : debugReporter)
 	   , _reporter_cbk(registerReporter(_instance, _reporter))
 	{}
@@ -130,7 +161,8 @@ namespace vuh {
 
 	/// Move constructor
 	Instance::Instance(Instance&& o) noexcept
-	   : _instance(o._instance)
+	   : _api_version(o._api_version)
+	   , _instance(o._instance)
 	   , _reporter(o._reporter)
 	   , _reporter_cbk(o._reporter_cbk)
 	{
@@ -140,6 +172,7 @@ namespace vuh {
 	/// Move assignment
 	auto Instance::operator=(Instance&& o) noexcept-> Instance& {
 		using std::swap;
+		swap(_api_version, o._api_version);
 		swap(_instance, o._instance);
 		swap(_reporter, o._reporter);
 		swap(_reporter_cbk, o._reporter_cbk);
@@ -192,4 +225,15 @@ namespace vuh {
 	{
 		return _extensions;
 	}
+
+	/// @return true if the instance extension with a given name is enabled
+	auto Instance::hasExtension(const char* name) const-> bool {
+		return contains(name, _extensions, [](const char* e){ return e; });
+	}
+
+	/// @return address of the instance-level function with a given name (i.e. from some extension),
+	/// nullptr if no such function is available.
+	auto Instance::getProcAddr(const char* name) const-> PFN_vkVoidFunction {
+		return _instance.getProcAddr(name);
+	}
 } // namespace vuh
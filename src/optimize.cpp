@@ -0,0 +1,142 @@
+#include <vuh/optimize.h>
+#include <vuh/error.h>
+#include <vuh/internal/utils.h>
+#include <vuh/utils.h>
+
+#ifdef VUH_WITH_SPIRV_TOOLS
+#include <spirv-tools/optimizer.hpp>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace {
+	/// Version of the optimized code cache format. Bump to invalidate the caches written before.
+	constexpr uint64_t opt_cache_version = 1;
+
+	/// @return hash identifying the optimization result of the code with given recipe,
+	/// frozen specialization constants and Vulkan version
+	auto opt_hash(const std::vector<char>& code, vuh::SpirvOpt recipe
+	              , const vk::SpecializationInfo* freeze, uint32_t api_version
+	              )-> uint64_t
+	{
+		auto r = vuh::hash_bytes(&opt_cache_version, sizeof(opt_cache_version));
+		r = vuh::hash_bytes(&recipe, sizeof(recipe), r);
+		r = vuh::hash_bytes(&api_version, sizeof(api_version), r);
+		r = vuh::hash_bytes(code.data(), code.size(), r);
+		if(freeze){
+			r = vuh::hash_bytes(freeze->pMapEntries
+			                    , freeze->mapEntryCount*sizeof(vk::SpecializationMapEntry), r);
+			r = vuh::hash_bytes(freeze->pData, freeze->dataSize, r);
+		}
+		return r;
+	}
+
+#ifdef VUH_WITH_SPIRV_TOOLS
+	/// @return values of specialization constants as bit patterns (little endian 32-bit words,
+	/// the smaller values zero-extended), keyed by the constant id
+	auto spec_values(const vk::SpecializationInfo& info
+	                 )-> std::unordered_map<uint32_t, std::vector<uint32_t>>
+	{
+		auto r = std::unordered_map<uint32_t, std::vector<uint32_t>>{};
+		const auto data = static_cast<const char*>(info.pData);
+		for(uint32_t i = 0; i < info.mapEntryCount; ++i){
+			const auto& e = info.pMapEntries[i];
+			auto words = std::vector<uint32_t>((e.size + sizeof(uint32_t) - 1)/sizeof(uint32_t), 0u);
+			std::memcpy(words.data(), data + e.offset, e.size);
+			r[e.constantID] = std::move(words);
+		}
+		return r;
+	}
+
+	/// Optimize SPIR-V code with SPIRV-Tools.
+	/// @throws vuh::CompilationFailure
+	auto optimize(const std::vector<char>& code, vuh::SpirvOpt recipe
+	              , const vk::SpecializationInfo* freeze, uint32_t api_version
+	              )-> std::vector<char>
+	{
+		auto opt = spvtools::Optimizer(api_version >= VK_API_VERSION_1_1 ? SPV_ENV_VULKAN_1_1
+		                                                                 : SPV_ENV_VULKAN_1_0);
+		auto log = std::string{};
+		opt.SetMessageConsumer([&log](spv_message_level_t level, const char*
+		                              , const spv_position_t&, const char* message)
+		{
+			if(level <= SPV_MSG_ERROR){
+				log += std::string(message) + "\n";
+			}
+		});
+		if(freeze){ // frozen constants go first so that other passes may fold them
+			opt.RegisterPass(spvtools::CreateSetSpecConstantDefaultValuePass(spec_values(*freeze)));
+			opt.RegisterPass(spvtools::CreateFreezeSpecConstantValuePass());
+		}
+		if(recipe == vuh::SpirvOpt::Performance){
+			opt.RegisterPerformancePasses();
+		} else if(recipe == vuh::SpirvOpt::Size){
+			opt.RegisterSizePasses();
+		}
+		auto words = std::vector<uint32_t>(code.size()/sizeof(uint32_t));
+		std::memcpy(words.data(), code.data(), words.size()*sizeof(uint32_t));
+		auto optimized = std::vector<uint32_t>{};
+		if(!opt.Run(words.data(), words.size(), &optimized)){
+			throw vuh::CompilationFailure("SPIR-V optimization failed: " + log);
+		}
+		auto r = std::vector<char>(optimized.size()*sizeof(uint32_t));
+		std::memcpy(r.data(), optimized.data(), r.size());
+		return r;
+	}
+#else
+	auto optimize(const std::vector<char>& code, vuh::SpirvOpt, const vk::SpecializationInfo*
+	              , uint32_t)-> std::vector<char>
+	{
+		return code;
+	}
+#endif
+} // namespace
+
+namespace vuh {
+	/// @return true if vuh is built with SPIRV-Tools, so that optimize_spirv() actually optimizes
+	auto spirv_opt_supported()-> bool {
+#ifdef VUH_WITH_SPIRV_TOOLS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/// Run the optimization recipe on SPIR-V code.
+	/// If specialization info is given the specialization constants are frozen to its values
+	/// (turned into regular constants) before optimization, so those can be folded into the code.
+	/// Constants with ids not declared in the kernel are ignored.
+	/// If cache directory is given, the optimized code is looked up there first by the hash of
+	/// the code, recipe, frozen values and Vulkan version, and stored there after optimization.
+	/// The directory should exist.
+	/// Without SPIRV-Tools (VUH_WITH_SPIRV_TOOLS build option is off) the code is returned as is,
+	/// freezing is then left to the specialization at pipeline creation.
+	/// @throws vuh::CompilationFailure if optimizer fails (e.g. code is not valid SPIR-V)
+	/// @throws vuh::FileWriteFailure if optimized code could not be stored to cache.
+	auto optimize_spirv(const std::vector<char>& code ///< SPIR-V code to optimize
+	                    , SpirvOpt recipe              ///< optimization recipe
+	                    , const vk::SpecializationInfo* freeze ///< specialization constants to freeze, nullptr to keep them
+	                    , const std::string& cache_dir ///< directory of the optimized code cache, empty for no caching
+	                    , uint32_t api_version         ///< Vulkan version code is to be run with
+	                    )-> std::vector<char>
+	{
+		if(!spirv_opt_supported() || (recipe == SpirvOpt::None && !freeze)){
+			return code;
+		}
+		if(cache_dir.empty()){
+			return optimize(code, recipe, freeze, api_version);
+		}
+		const auto path = spirv_cache_path(cache_dir, opt_hash(code, recipe, freeze, api_version));
+		auto r = read_cached_spirv(path);
+		if(r.empty()){
+			r = optimize(code, recipe, freeze, api_version);
+			write_file_atomic(path, [&](std::ostream& fout){
+				return bool(fout.write(r.data(), std::streamsize(r.size())));
+			});
+		}
+		return r;
+	}
+} // namespace vuh
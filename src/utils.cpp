@@ -1,6 +1,7 @@
 #include <vuh/utils.h>
 #include <vuh/error.h>
 #include <vuh/arr/arrayUtils.h>
+#include <vuh/img/imageUtils.h>
 
 #include <fstream>
 
@@ -21,7 +22,8 @@ namespace vuh {
 namespace arr {
 	/// Copy data between device buffers using the device transfer command pool and queue.
 	/// Source and destination buffers are supposed to be allocated on the same device.
-	/// Fully sync, no latency hiding whatsoever.
+	/// Fully sync, no latency hiding whatsoever. Waits on the fence of the copy rather than for
+	/// the transfer queue to go idle (work submitted to the queue earlier is still waited for).
 	auto copyBuf(vuh::Device& device ///< device where buffers are allocated
 	             , vk::Buffer src    ///< source buffer
 	             , vk::Buffer dst    ///< destination buffer
@@ -30,15 +32,120 @@ namespace arr {
 	             , size_t dst_offset ///< destination buffer offset (bytes)
 	             )-> void
 	{
-		auto cmd_buf = device.transferCmdBuffer();
-		cmd_buf.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+		auto cmd_buf = device.beginTransferCmdBuffer(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
 		auto region = vk::BufferCopy(src_offset, dst_offset, size_bytes);
 		cmd_buf.copyBuffer(src, dst, 1, &region);
 		cmd_buf.end();
-		auto queue = device.transferQueue();
-		auto submit_info = vk::SubmitInfo(0, nullptr, nullptr, 1, &cmd_buf);
-		queue.submit({submit_info}, nullptr);
-		queue.waitIdle();
+		device.submitSync(device.transferQueue(), cmd_buf, device.syncSpin());
 	}
 } // namespace arr
+
+namespace img {
+namespace {
+	/// Access types of kernels to images. Images are kept in general layout and may be both read
+	/// and written by kernels.
+	const auto shader_access = vk::AccessFlags(vk::AccessFlagBits::eShaderRead)
+	                             | vk::AccessFlagBits::eShaderWrite;
+
+	/// @return subresource range covering the whole (single mip level, single layer) color image
+	auto colorRange()-> vk::ImageSubresourceRange {
+		return {vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1};
+	}
+
+	/// @return buffer-image copy region for the whole tightly packed image
+	auto copyRegion(vk::Extent3D extent)-> vk::BufferImageCopy {
+		return {0, 0, 0, {vk::ImageAspectFlagBits::eColor, 0, 0, 1}, {0, 0, 0}, extent};
+	}
+
+	/// Record barrier on the image kept in general layout.
+	auto recordBarrier(vk::CommandBuffer cmd_buf, vk::Image image
+	                   , vk::AccessFlags src_access, vk::PipelineStageFlags src_stage
+	                   , vk::AccessFlags dst_access, vk::PipelineStageFlags dst_stage
+	                   )-> void
+	{
+		auto barrier = vk::ImageMemoryBarrier(src_access, dst_access
+		                                      , vk::ImageLayout::eGeneral, vk::ImageLayout::eGeneral
+		                                      , VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED
+		                                      , image, colorRange());
+		cmd_buf.pipelineBarrier(src_stage, dst_stage, {}, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	/// Record commands to a command buffer of the device compute pool, submit that to the device
+	/// compute queue and wait till it completes.
+	/// Image transfers go through the compute queue, so that images never change the queue
+	/// family ownership and barriers may involve compute shader stage.
+	template<class F>
+	auto submitSync(vuh::Device& device, F&& record)-> void {
+		auto cmd_buf = device.acquireComputeCmdBuffer();
+		try {
+			cmd_buf.begin({vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+			record(cmd_buf);
+			cmd_buf.end();
+			device.submitSync(device.computeQueue(), cmd_buf, device.syncSpin());
+		} catch(vk::Error&) {
+			device.freeCommandBuffers(device.computeCmdPool(), 1, &cmd_buf);
+			throw;
+		}
+		device.recycleComputeCmdBuffer(cmd_buf);
+	}
+} // namespace
+
+	/// Record transition of the freshly created image to general layout.
+	/// Images stay in that layout for the whole lifetime, which is suitable for both storage and
+	/// sampled access by kernels as well as for transfers.
+	auto recordInitLayout(vk::CommandBuffer cmd_buf, vk::Image image)-> void {
+		auto barrier = vk::ImageMemoryBarrier({}, shader_access
+		                                      , vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral
+		                                      , VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED
+		                                      , image, colorRange());
+		cmd_buf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe
+		                        , vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer
+		                        , {}, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	/// Record copy of the tightly packed buffer data to the whole image.
+	/// Copy is fenced by barriers against the preceding and following kernels accessing the image.
+	auto recordCopyBufToImage(vk::CommandBuffer cmd_buf
+	                          , vk::Buffer src, vk::Image dst, vk::Extent3D extent
+	                          )-> void
+	{
+		recordBarrier(cmd_buf, dst, shader_access, vk::PipelineStageFlagBits::eComputeShader
+		              , vk::AccessFlagBits::eTransferWrite, vk::PipelineStageFlagBits::eTransfer);
+		auto region = copyRegion(extent);
+		cmd_buf.copyBufferToImage(src, dst, vk::ImageLayout::eGeneral, 1, &region);
+		recordBarrier(cmd_buf, dst, vk::AccessFlagBits::eTransferWrite, vk::PipelineStageFlagBits::eTransfer
+		              , shader_access, vk::PipelineStageFlagBits::eComputeShader);
+	}
+
+	/// Record copy of the whole image to the buffer (tightly packed).
+	/// Copy waits for the preceding kernels writing to the image.
+	auto recordCopyImageToBuf(vk::CommandBuffer cmd_buf
+	                          , vk::Image src, vk::Buffer dst, vk::Extent3D extent
+	                          )-> void
+	{
+		recordBarrier(cmd_buf, src, vk::AccessFlagBits::eShaderWrite, vk::PipelineStageFlagBits::eComputeShader
+		              , vk::AccessFlagBits::eTransferRead, vk::PipelineStageFlagBits::eTransfer);
+		auto region = copyRegion(extent);
+		cmd_buf.copyImageToBuffer(src, vk::ImageLayout::eGeneral, dst, 1, &region);
+	}
+
+	/// Transition the image to general layout. Fully sync.
+	auto initLayout(vuh::Device& device, vk::Image image)-> void {
+		submitSync(device, [=](vk::CommandBuffer cmd_buf){ recordInitLayout(cmd_buf, image); });
+	}
+
+	/// Copy buffer data to the image. Fully sync.
+	auto copyBufToImage(vuh::Device& device, vk::Buffer src, vk::Image dst, vk::Extent3D extent)-> void {
+		submitSync(device, [=](vk::CommandBuffer cmd_buf){
+			recordCopyBufToImage(cmd_buf, src, dst, extent);
+		});
+	}
+
+	/// Copy image data to the buffer. Fully sync.
+	auto copyImageToBuf(vuh::Device& device, vk::Image src, vk::Buffer dst, vk::Extent3D extent)-> void {
+		submitSync(device, [=](vk::CommandBuffer cmd_buf){
+			recordCopyImageToBuf(cmd_buf, src, dst, extent);
+		});
+	}
+} // namespace img
 } // namespace vuh
@@ -0,0 +1,166 @@
+#include <catch2/catch.hpp>
+#include "approx.hpp"
+#include "saxpy_fixture.hpp"
+
+#include <vuh/vuh.h>
+#include <vuh/array.hpp>
+#include <vuh/image.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using test::approx;
+
+TEST_CASE_METHOD(test::Saxpy<1024>, "array views bound at offsets", "[program][correctness]"){
+	constexpr auto n_tiles = 4u;
+	constexpr auto tile_size = size/n_tiles;
+	auto program = Program(device, "../shaders/saxpy.spv");
+	program.grid_for(tile_size, 64).spec(64);
+	for(uint32_t t = 0; t < n_tiles; t += 2){ // same bindings at other offsets
+		program({tile_size, a}, vuh::array_view(d_y, t*tile_size, (t + 1)*tile_size)
+		                      , vuh::array_view(d_x, t*tile_size, (t + 1)*tile_size));
+	}
+	auto out_ref = std::vector<float>(size, 1.0f);
+	for(uint32_t t = 0; t < n_tiles; t += 2){
+		std::fill_n(begin(out_ref) + t*tile_size, tile_size, 1.0f + a*2.0f);
+	}
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(out_ref).eps(1.e-5));
+
+	if(device.properties().limits.minStorageBufferOffsetAlignment > sizeof(float)){
+		REQUIRE_THROWS_AS(vuh::array_view(d_y, 1, tile_size + 1), std::invalid_argument); // misaligned
+	}
+}
+
+TEST_CASE("array list parameter", "[program][correctness]"){
+	const auto size = uint32_t(128);
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	if(!device.features().descriptor_indexing){
+		WARN("device does not support descriptor indexing, skipping");
+		return;
+	}
+
+	auto shards = std::vector<vuh::Array<float>>{};
+	for(size_t k = 0; k < 5; ++k){
+		shards.emplace_back(device, std::vector<float>(size, float(k + 1)));
+	}
+	auto d_y = vuh::Array<float>(device, size);
+	auto y = std::vector<float>(size);
+
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size; uint32_t n_shards;};
+	auto program = vuh::Program<Specs, Params>(device, "../shaders/sum_list.spv");
+	program.grid(size/64).spec(64);
+
+	SECTION("list of arrays"){
+		program({size, uint32_t(shards.size())}, d_y, shards);
+		d_y.toHost(begin(y));
+		REQUIRE(y == approx(std::vector<float>(size, 15.0f)).eps(1.e-5));
+
+		// rebind with one element replaced and the list shrunk
+		shards[1] = vuh::Array<float>(device, std::vector<float>(size, 10.0f));
+		shards.pop_back();
+		program({size, uint32_t(shards.size())}, d_y, shards);
+		d_y.toHost(begin(y));
+		REQUIRE(y == approx(std::vector<float>(size, 1.0f + 10.0f + 3.0f + 4.0f)).eps(1.e-5));
+	}
+	SECTION("list of array views"){
+		auto views = std::vector<vuh::ArrayView<vuh::Array<float>>>{};
+		for(auto& s: shards){
+			views.push_back(vuh::array_view(s, 0, size));
+		}
+		program({size, uint32_t(views.size())}, d_y, views);
+		d_y.toHost(begin(y));
+		REQUIRE(y == approx(std::vector<float>(size, 15.0f)).eps(1.e-5));
+	}
+}
+
+TEST_CASE("arrays passed by device address", "[program][correctness]"){
+	const auto size = uint32_t(128);
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	if(!device.features().buffer_device_address){
+		WARN("device does not support buffer device address, skipping");
+		return;
+	}
+
+	auto arrays = std::vector<vuh::Array<float>>{};
+	auto addresses = std::vector<uint64_t>{};
+	for(size_t k = 0; k < 3; ++k){
+		arrays.emplace_back(device, std::vector<float>(size, float(k + 1)), vk::MemoryPropertyFlags{}
+		                    , vk::BufferUsageFlagBits::eShaderDeviceAddressKHR);
+		addresses.push_back(arrays.back().device_address());
+	}
+	auto d_refs = vuh::Array<uint64_t>(device, addresses);
+	auto d_y = vuh::Array<float>(device, size);
+
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size; uint32_t n_arrays;};
+	auto program = vuh::Program<Specs, Params>(device, "../shaders/sum_address.spv");
+	program.grid(size/64).spec(64)({size, uint32_t(arrays.size())}, d_y, d_refs);
+
+	auto y = std::vector<float>(size);
+	d_y.toHost(begin(y));
+	REQUIRE(y == approx(std::vector<float>(size, 6.0f)).eps(1.e-5));
+}
+
+TEST_CASE("uniform and texel array parameters", "[program][correctness]"){
+	const auto size = uint32_t(128);
+	const auto coefs = std::vector<float>{1.0f, 2.0f, 3.0f, 4.0f};
+	auto x = std::vector<uint8_t>(size);
+	auto out_ref = std::vector<float>(size);
+	for(size_t i = 0; i < size; ++i){
+		x[i] = uint8_t(2*i);
+		out_ref[i] = coefs[i % 4]*float(x[i])/255.0f;
+	}
+
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	auto d_y = vuh::Array<float>(device, size);
+	auto d_coefs = vuh::UniformArray<float>(device, coefs);
+	auto d_x = vuh::TexelArray<uint8_t>(device, vk::Format::eR8Unorm, x);
+
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size;};
+	auto program = vuh::Program<Specs, Params>(device, "../shaders/scale_texel.spv");
+	program.grid(size/64).spec(64)({size}, d_y, d_coefs, d_x);
+
+	auto y = std::vector<float>(size);
+	d_y.toHost(begin(y));
+	REQUIRE(y == approx(out_ref).eps(1.e-3));
+}
+
+TEST_CASE("image parameters", "[program][correctness]"){
+	const auto width = uint32_t(40);
+	const auto height = uint32_t(24);
+	auto x = std::vector<float>(width*height);
+	auto out_ref = std::vector<float>(width*height);
+	for(size_t i = 0; i < x.size(); ++i){
+		x[i] = float(i);
+		out_ref[i] = 2.0f*x[i];
+	}
+
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	auto d_y = vuh::Image2D<float>(device, width, height);
+	auto d_x = vuh::Image2D<float>(device, width, height);
+	d_x.fromHost(begin(x), end(x));
+	auto s_x = vuh::sampled(d_x);
+
+	struct Params{uint32_t width; uint32_t height;};
+	auto program = vuh::Program<vuh::typelist<>, Params>(device, "../shaders/scale_image.spv");
+	program.grid((width + 7)/8, (height + 7)/8)({width, height}, d_y, s_x);
+
+	SECTION("sync transfer"){
+		auto y = d_y.toHost<std::vector<float>>();
+		REQUIRE(y == approx(out_ref));
+	}
+	SECTION("async transfer"){
+		auto y = std::vector<float>(width*height);
+		auto cpy = vuh::copy_async(d_y, begin(y));
+		cpy.wait();
+		REQUIRE(y == approx(out_ref));
+	}
+}
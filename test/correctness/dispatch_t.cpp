@@ -0,0 +1,67 @@
+#include <catch2/catch.hpp>
+#include "approx.hpp"
+#include "saxpy_fixture.hpp"
+
+#include <vuh/vuh.h>
+#include <vuh/array.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using test::approx;
+
+TEST_CASE_METHOD(test::Saxpy<100000>, "grid for elements and sliced run", "[program][correctness]"){
+	auto program = make_program(); // last workgroup sticks out of the arrays
+
+	SECTION("single run"){
+		program({size, a}, d_y, d_x);
+		REQUIRE(d_y.toHost<std::vector<float>>() == approx(expected(1)).eps(1.e-5));
+	}
+	SECTION("sliced run"){
+		if(!device.supportsDispatchBase()){
+			REQUIRE_THROWS_AS(program.run_sliced(std::chrono::microseconds(10), {size, a}, d_y, d_x)
+			                  , vuh::ExtensionNotFound);
+			REQUIRE(d_y.toHost<std::vector<float>>() == expected(0)); // nothing was run
+			WARN("device does not support dispatch base, skipping sliced run");
+			return;
+		}
+		const auto timed = program.timing(true);
+		program.run_sliced(std::chrono::microseconds(10), {size, a}, d_y, d_x);
+		if(timed){ // timestamps are written by the sliced run itself
+			REQUIRE(program.last_duration().count() > 0);
+		}
+		REQUIRE(d_y.toHost<std::vector<float>>() == approx(expected(1)).eps(1.e-5));
+	}
+}
+
+TEST_CASE_METHOD(test::Saxpy<>, "command buffer reused for unchanged arguments", "[program][correctness]"){
+	auto d_z = vuh::Array<float>(device, std::vector<float>(size, 4.0f));
+	auto program = make_program();
+	auto other = vuh::Program<vuh::typelist<>, Params>(device, "../shaders/saxpy_nospec.spv");
+	program({size, a}, d_y, d_x);
+	const auto version = device.computeCmdBufferVersion();
+	program({size, a}, d_y, d_x);
+	REQUIRE(device.computeCmdBufferVersion() == version); // replayed, not recorded
+
+	program({size, 2*a}, d_y, d_x);                      // push constants changed
+	other.grid(2)({size, a}, d_y, d_z);                  // other program records in between
+	const auto version_other = device.computeCmdBufferVersion();
+	program({size, 2*a}, d_y, d_x);
+	REQUIRE(device.computeCmdBufferVersion() != version_other); // recorded anew
+	program({size, a}, d_y, d_z);                        // arrays changed
+
+	const auto y_ref = 1.0f + 2*a*2.0f + 2*(2*a)*2.0f + 2*a*4.0f;
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(std::vector<float>(size, y_ref)).eps(1.e-5));
+
+	{
+		auto d_w = vuh::Array<float>(device, std::vector<float>(size, 8.0f));
+		program({size, a}, d_y, d_w);
+	}
+	auto d_v = vuh::Array<float>(device, std::vector<float>(size, 16.0f)); // may get the buffer of d_w
+	const auto version_v = device.computeCmdBufferVersion();
+	program({size, a}, d_y, d_v);
+	REQUIRE(device.computeCmdBufferVersion() != version_v); // recorded anew
+	REQUIRE(d_y.toHost<std::vector<float>>()
+	        == approx(std::vector<float>(size, y_ref + a*8.0f + a*16.0f)).eps(1.e-5));
+}
@@ -0,0 +1,130 @@
+#include <catch2/catch.hpp>
+#include "approx.hpp"
+#include "saxpy_fixture.hpp"
+#include "saxpy_spv.h" // SPIR-V embedded by vuh_compile_shader
+
+#include <vuh/vuh.h>
+#include <vuh/array.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using test::approx;
+
+TEST_CASE("persistent pipeline cache", "[program][correctness]"){
+	auto y = std::vector<float>(128, 1.0f);
+	auto x = std::vector<float>(128, 2.0f);
+	const auto a = 0.1f;
+	const auto cache_path = std::string("vuh_test_pipeline.cache");
+	std::remove(cache_path.c_str());
+
+	auto out_ref = y;
+	for(size_t i = 0; i < y.size(); ++i){
+		out_ref[i] += a*x[i];
+	}
+
+	auto instance = vuh::Instance();
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size; float a;};
+	{
+		auto device = instance.devices().at(0);
+		REQUIRE_FALSE(device.pipelineCacheFile(cache_path)); // no cache file yet
+		auto d_y = vuh::Array<float>(device, y);
+		auto d_x = vuh::Array<float>(device, x);
+		auto program = vuh::Program<Specs, Params>(device, "../shaders/saxpy.spv");
+		program.grid(128/64).spec(64)({128, a}, d_y, d_x);
+		device.savePipelineCache();
+	}
+	auto device = instance.devices().at(0);
+	REQUIRE(device.pipelineCacheFile(cache_path));
+	auto d_y = vuh::Array<float>(device, y);
+	auto d_x = vuh::Array<float>(device, x);
+	auto program = vuh::Program<Specs, Params>(device, "../shaders/saxpy.spv");
+	program.grid(128/64).spec(64)({128, a}, d_y, d_x);
+	d_y.toHost(begin(y));
+
+	REQUIRE(y == approx(out_ref).eps(1.e-5));
+	std::remove(cache_path.c_str());
+}
+
+TEST_CASE_METHOD(test::Saxpy<>, "switch specialization constants between runs", "[program][correctness]"){
+	const auto workgroup_sizes = std::vector<uint32_t>{64, 32, 128, 64};
+	auto program = Program(device, "../shaders/saxpy.spv");
+	SECTION("independent pipelines"){}
+	SECTION("derivative pipelines"){
+		program.derive_pipelines();
+	}
+	for(auto wg_size: workgroup_sizes){
+		program.grid(size/wg_size).spec(wg_size)({size, a}, d_y, d_x);
+	}
+
+	REQUIRE(d_y.toHost<std::vector<float>>()
+	        == approx(expected(uint32_t(workgroup_sizes.size()))).eps(1.e-5));
+}
+
+TEST_CASE_METHOD(test::Saxpy<1000>, "optimized kernel code", "[program][correctness]"){
+	auto program = Program(device, "../shaders/saxpy.spv");
+	const auto code = vuh::read_spirv("../shaders/saxpy.spv");
+
+	SECTION("performance recipe"){
+		program.optimize(vuh::SpirvOpt::Performance);
+		if(vuh::spirv_opt_supported()){
+			REQUIRE(vuh::optimize_spirv(code, vuh::SpirvOpt::Performance) != code);
+		}
+	}
+	SECTION("size recipe, frozen specialization constants"){
+		program.optimize(vuh::SpirvOpt::Size, true, ".");
+		if(vuh::spirv_opt_supported()){
+			const auto wg = uint32_t(64);
+			const auto entry = vk::SpecializationMapEntry(0, 0, sizeof(wg));
+			const auto freeze = vk::SpecializationInfo(1, &entry, sizeof(wg), &wg);
+			const auto optimized = vuh::optimize_spirv(code, vuh::SpirvOpt::Size);
+			const auto frozen = vuh::optimize_spirv(code, vuh::SpirvOpt::Size, &freeze);
+			REQUIRE(optimized.size() < code.size());
+			REQUIRE(frozen != optimized);
+		}
+	}
+	if(!vuh::spirv_opt_supported()){
+		REQUIRE(vuh::optimize_spirv(code, vuh::SpirvOpt::Size) == code);
+		WARN("vuh is built without SPIRV-Tools, kernel code is not optimized");
+	}
+	program.grid_for(size, 64).spec(64)({size, a}, d_y, d_x);
+	program.grid_for(size, 128).spec(128)({size, a}, d_y, d_x); // another frozen variant
+
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(expected(2)).eps(1.e-5));
+}
+
+TEST_CASE_METHOD(test::Saxpy<>, "embedded kernel code and shared objects", "[program][correctness]"){
+	auto m1 = device.sharedShaderModule(saxpy_spv, sizeof(saxpy_spv));
+	auto m2 = device.sharedShaderModule(saxpy_spv, sizeof(saxpy_spv));
+	REQUIRE(m1 == m2);
+	device.releaseShared(m1);
+	device.releaseShared(m2);
+
+	auto programs = std::vector<Program>{};
+	programs.reserve(3);
+	for(int i = 0; i < 3; ++i){
+		programs.emplace_back(device, saxpy_spv);
+	}
+	for(auto& p: programs){
+		p.grid(size/64).spec(64)({size, a}, d_y, d_x);
+	}
+
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(expected(3)).eps(1.e-5));
+}
+
+TEST_CASE_METHOD(test::Saxpy<>, "pipelines prepared in background", "[program][correctness]"){
+	auto p_spec = Program(device, "../shaders/saxpy.spv");
+	auto p_nospec = vuh::Program<vuh::typelist<>, Params>(device, "../shaders/saxpy_nospec.spv");
+	p_spec.spec(32).prepare_async(d_y, d_x).spec(64).prepare_async(d_y, d_x);
+	vuh::prepare_all(std::tie(p_nospec, d_y, d_x), std::tie(p_spec, d_y, d_x)); // already pending, noop for p_spec
+
+	p_spec.grid(size/64)({size, a}, d_y, d_x);
+	p_spec.grid(size/32).spec(32)({size, a}, d_y, d_x);
+	p_nospec.grid(2)({size, a}, d_y, d_x);
+
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(expected(3)).eps(1.e-5));
+}
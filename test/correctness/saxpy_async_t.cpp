@@ -4,6 +4,7 @@
 #include <vuh/vuh.h>
 #include <vuh/array.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <cstdint>
 
@@ -101,3 +102,136 @@ TEST_CASE("data transfer and computation interleaved. sync host side.", "[correc
 	}
 
 }
+
+TEST_CASE("several invocations of the same program in flight", "[correctness][async]"){
+	constexpr auto arr_size = 1024;
+	constexpr auto n_tiles = 4;
+	constexpr auto tile_size = arr_size/n_tiles;
+	const auto a = 0.1f;
+
+	auto y = std::vector<float>(arr_size, 1.0f);
+	auto x = std::vector<float>(arr_size);
+	for(size_t i = 0; i < x.size(); ++i){
+		x[i] = float(i);
+	}
+	auto out_ref = y;
+	for(size_t i = 0; i < y.size(); ++i){
+		out_ref[i] += a*x[i];
+	}
+
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	auto d_y = vuh::Array<float>(device, y);
+	auto d_x = vuh::Array<float>(device, x);
+
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size; float a;};
+	auto program = vuh::Program<Specs, Params>(device, "../shaders/saxpy.spv");
+	program.grid(tile_size/64).spec(64);
+	{
+		auto tokens = std::vector<vuh::Delayed<vuh::detail::Compute>>{};
+		for(size_t i = 0; i < n_tiles; ++i){
+			tokens.push_back(program.run_async({tile_size, a}
+			                                   , vuh::array_view(d_y, i*tile_size, (i + 1)*tile_size)
+			                                   , vuh::array_view(d_x, i*tile_size, (i + 1)*tile_size)));
+		}
+	} // wait for all
+	d_y.toHost(begin(y));
+
+	REQUIRE(y == approx(out_ref).eps(1.e-5));
+}
+
+TEST_CASE("parameters too large for push constants", "[correctness][async]"){
+	constexpr auto arr_size = 1024;
+	constexpr auto n_tiles = 4;
+	constexpr auto tile_size = arr_size/n_tiles;
+
+	struct Params{uint32_t size; float a; uint32_t offset; float pad; float shifts[8][4];};
+	using Program = vuh::Program<vuh::typelist<uint32_t>, Params>;
+	static_assert(Program::params_in_uniform, "parameters expected to be passed in uniform buffer");
+
+	auto y = std::vector<float>(arr_size, 1.0f);
+	auto x = std::vector<float>(arr_size);
+	for(size_t i = 0; i < x.size(); ++i){
+		x[i] = float(i);
+	}
+	auto params = std::vector<Params>(n_tiles);
+	auto out_ref = y;
+	for(uint32_t t = 0; t < n_tiles; ++t){
+		params[t] = Params{tile_size, 0.1f*float(t + 1), t*tile_size, 0.0f, {}};
+		for(size_t k = 0; k < 8; ++k){
+			params[t].shifts[k][0] = float(k*(t + 1));
+		}
+		for(size_t i = 0; i < tile_size; ++i){
+			out_ref[t*tile_size + i] += params[t].a*x[t*tile_size + i] + params[t].shifts[i % 8][0];
+		}
+	}
+
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	auto d_y = vuh::Array<float>(device, y);
+	auto d_x = vuh::Array<float>(device, x);
+
+	auto program = Program(device, "../shaders/saxpy_uniform.spv");
+	program.grid(tile_size/64).spec(64);
+	{
+		auto tokens = std::vector<vuh::Delayed<vuh::detail::Compute>>{};
+		for(size_t t = 0; t < n_tiles; ++t){
+			tokens.push_back(program.run_async(params[t], d_y, d_x));
+		}
+	} // wait for all
+	d_y.toHost(begin(y));
+
+	REQUIRE(y == approx(out_ref).eps(1.e-5));
+
+	// async run may outlive its program, descriptor sets and parameters are kept till it completes
+	auto token = Program(device, "../shaders/saxpy_uniform.spv").grid(tile_size/64).spec(64)
+	                                                            .run_async(params[0], d_y, d_x);
+	token.wait();
+	d_y.toHost(begin(y));
+	for(size_t i = 0; i < tile_size; ++i){
+		out_ref[i] += params[0].a*x[i] + params[0].shifts[i % 8][0];
+	}
+	REQUIRE(y == approx(out_ref).eps(1.e-5));
+}
+
+TEST_CASE("indirect dispatch chained to the kernel computing the grid", "[correctness][async]"){
+	constexpr auto arr_size = uint32_t(256);
+	const auto threshold = 100.0f;
+	auto x = std::vector<float>(arr_size);
+	for(size_t i = 0; i < x.size(); ++i){
+		x[i] = float((i*37)%arr_size);
+	}
+	auto out_ref = std::vector<float>{};
+	for(auto v: x){
+		if(v > threshold){
+			out_ref.push_back(2.0f*v);
+		}
+	}
+	std::sort(begin(out_ref), end(out_ref));
+
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	auto d_grid = vuh::Array<uint32_t>(device, std::vector<uint32_t>{0, 1, 1, 0}
+	                                   , {}, vk::BufferUsageFlagBits::eIndirectBuffer);
+	auto d_survivors = vuh::Array<float>(device, arr_size);
+	auto d_x = vuh::Array<float>(device, x);
+
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size; float threshold;};
+	auto filter = vuh::Program<Specs, Params>(device, "../shaders/filter_compact.spv");
+	auto scale = vuh::Program<Specs>(device, "../shaders/scale_survivors.spv");
+	{
+		auto f = filter.grid(arr_size/64).spec(64)
+		               .run_async({arr_size, threshold}, d_grid, d_survivors, d_x);
+		auto s = scale.spec(64).run_indirect_async(d_grid, d_grid, d_survivors);
+	} // wait for both
+
+	const auto grid = d_grid.toHost<std::vector<uint32_t>>();
+	REQUIRE(grid[3] == out_ref.size());
+	REQUIRE(grid[0] == (out_ref.size() + 63)/64);
+	auto y = d_survivors.toHost<std::vector<float>>();
+	y.resize(grid[3]);
+	std::sort(begin(y), end(y));
+	REQUIRE(y == approx(out_ref).eps(1.e-5));
+}
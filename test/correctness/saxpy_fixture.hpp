@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vuh/vuh.h>
+#include <vuh/array.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace test{
+
+/// Fixture of the tests running the saxpy kernel (y += a*x) on the first device.
+/// Arrays y and x of Size elements are filled with 1 and 2.
+template<uint32_t Size=128>
+struct Saxpy {
+	using Specs = vuh::typelist<uint32_t>; ///< workgroup size
+	struct Params{uint32_t size; float a;};
+	using Program = vuh::Program<Specs, Params>;
+
+	static constexpr uint32_t size = Size;
+	static constexpr float a = 0.1f;       ///< saxpy scaling constant
+
+	Saxpy()
+	   : device(instance.devices().at(0))
+	   , d_y(device, std::vector<float>(size, 1.0f))
+	   , d_x(device, std::vector<float>(size, 2.0f))
+	{}
+
+	/// @return saxpy program with workgroups of a given size covering the whole arrays
+	auto make_program(uint32_t workgroup_size=64)-> Program {
+		auto p = Program(device, "../shaders/saxpy.spv");
+		p.grid_for(size, workgroup_size).spec(workgroup_size);
+		return p;
+	}
+
+	/// @return expected content of y after a given number of saxpy runs over the whole arrays
+	static auto expected(uint32_t n_runs)-> std::vector<float> {
+		return std::vector<float>(size, 1.0f + float(n_runs)*a*2.0f);
+	}
+
+	vuh::Instance instance;
+	vuh::Device device;
+	vuh::Array<float> d_y;
+	vuh::Array<float> d_x;
+}; // struct Saxpy
+
+template<uint32_t Size> constexpr uint32_t Saxpy<Size>::size;
+template<uint32_t Size> constexpr float Saxpy<Size>::a;
+
+} // namespace test
@@ -4,9 +4,18 @@
 
 #include <vuh/vuh.h>
 #include <vuh/array.hpp>
+#include <vuh/autotune.hpp>
 
-#include <vector>
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
 
 using test::approx;
 
@@ -104,3 +113,153 @@ TEST_CASE("saxpy_repeated_1D", "[correctness]"){
 		REQUIRE(y == approx(out_ref).eps(1.e-5));
 	}
 }
+
+TEST_CASE("workgroup size autotune", "[program][correctness]"){
+	const auto size = uint32_t(1 << 16);
+	const auto a = 0.1f;
+	auto y = std::vector<float>(size, 1.0f);
+	auto x = std::vector<float>(size, 2.0f);
+	const auto tuning_path = std::string("vuh_test_tuning.db");
+	std::remove(tuning_path.c_str());
+
+	auto instance = vuh::Instance();
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size; float a;};
+	auto best = uint32_t(0);
+	{
+		auto device = instance.devices().at(0);
+		REQUIRE_FALSE(device.tuningFile(tuning_path)); // no tuning database yet
+		auto d_y = vuh::Array<float>(device, y);
+		auto d_x = vuh::Array<float>(device, x);
+		auto program = vuh::Program<Specs, Params>(device, "../shaders/saxpy.spv");
+		const auto candidates = vuh::workgroup_candidates(device);
+		best = vuh::autotune(program, size, Params{size, a}, d_y, d_x);
+		REQUIRE(std::find(begin(candidates), end(candidates), best) != end(candidates));
+		REQUIRE(std::get<0>(program.specs()) == best);
+	}
+	auto device = instance.devices().at(0);
+	REQUIRE(device.tuningFile(tuning_path));
+	REQUIRE(device.tunedWorkgroupSize(vuh::Program<Specs, Params>(device, "../shaders/saxpy.spv")
+	                                  .kernel_hash()) == best);
+	auto d_y = vuh::Array<float>(device, y);
+	auto d_x = vuh::Array<float>(device, x);
+	auto program = vuh::Program<Specs, Params>(device, "../shaders/saxpy.spv");
+	REQUIRE(std::get<0>(program.specs()) == best); // tuned value picked up at construction
+	program.grid_for(size, best)({size, a}, d_y, d_x);
+	d_y.toHost(begin(y));
+
+	REQUIRE(y == approx(std::vector<float>(size, 1.0f + a*2.0f)).eps(1.e-5));
+	std::remove(tuning_path.c_str());
+}
+
+TEST_CASE("subgroup size specialization", "[program][correctness]"){
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	const auto& features = device.features();
+	if(!(features.subgroup_operations & vk::SubgroupFeatureFlagBits::eArithmetic)){
+		WARN("subgroup arithmetic is not supported, skipping");
+		return;
+	}
+	const auto size = uint32_t(1024);
+	const auto wg = uint32_t(128);
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size;};
+	auto d_y = vuh::Array<float>(device, std::vector<float>(size, 1.0f));
+	auto d_sizes = vuh::Array<uint32_t>(device, 2);
+	auto program = vuh::Program<Specs, Params>(device, "../shaders/subgroup_sum.spv");
+
+	program.spec_subgroup_size();
+
+	SECTION("device subgroup size"){
+		REQUIRE(program.subgroup_size() == features.subgroup_size);
+		program.grid_for(size, wg).spec(wg)({size}, d_y, d_sizes);
+		auto sizes = d_sizes.toHost<std::vector<uint32_t>>();
+		REQUIRE(sizes[0] == features.subgroup_size);
+	}
+	SECTION("required subgroup size"){
+		if(!features.subgroup_size_control){
+			REQUIRE_THROWS_AS(program.require_subgroup_size(features.subgroup_size)
+			                  , vuh::ExtensionNotFound);
+			WARN("subgroup size control is not supported, skipping");
+			return;
+		}
+		REQUIRE_THROWS_AS(program.require_subgroup_size(features.max_subgroup_size*2)
+		                  , std::out_of_range);
+		const auto sg = features.min_subgroup_size;
+		program.require_subgroup_size(sg).grid_for(size, wg).spec(wg);
+		if(wg > sg*features.max_workgroup_subgroups){
+			REQUIRE_THROWS_AS(program({size}, d_y, d_sizes), std::out_of_range);
+			WARN("workgroup does not fit subgroups of the min size, skipping");
+			return;
+		}
+		program({size}, d_y, d_sizes);
+		auto sizes = d_sizes.toHost<std::vector<uint32_t>>();
+		REQUIRE(sizes[0] == sg);
+		REQUIRE(sizes[1] == sg);
+		REQUIRE(d_y.toHost<std::vector<float>>() == std::vector<float>(size, float(sg)));
+	}
+	SECTION("subgroup size constant id clash"){
+		program.spec_subgroup_size(0); // taken by the workgroup size
+		REQUIRE_THROWS_AS(program.grid_for(size, wg).spec(wg)({size}, d_y, d_sizes)
+		                  , std::invalid_argument);
+	}
+}
+
+TEST_CASE("kernel compiled from GLSL at run time", "[program][correctness]"){
+	const auto source = std::string(R"(
+		#version 450
+		layout(local_size_x = WORKGROUP_SIZE) in;
+		layout(std430, binding = 0) buffer lay0 { float arr_y[]; };
+		layout(std430, binding = 1) buffer lay1 { float arr_x[]; };
+		void main(){
+			const uint id = gl_GlobalInvocationID.x;
+			if(SIZE <= id){
+				return;
+			}
+			arr_y[id] += A*arr_x[id];
+		}
+	)");
+	const auto size = uint32_t(1000);
+	const auto wg = uint32_t(64);
+	const auto defines = vuh::GlslDefines{{"WORKGROUP_SIZE", std::to_string(wg)}
+	                                     , {"SIZE", std::to_string(size) + "u"}
+	                                     , {"A", "0.5"}};
+	const auto path = vuh::glsl_cache_path(source, defines, ".");
+
+	// code found in cache is returned as is, without compilation
+	auto stored = std::vector<char>(5*sizeof(uint32_t), 0);
+	const auto spirv_magic = uint32_t(0x07230203u);
+	std::memcpy(stored.data(), &spirv_magic, sizeof(spirv_magic));
+	{
+		auto fout = std::ofstream(path, std::ios::binary);
+		fout.write(stored.data(), std::streamsize(stored.size()));
+	}
+	REQUIRE(vuh::compile_glsl(source, defines, ".") == stored);
+	std::remove(path.c_str());
+
+	if(!vuh::glsl_supported()){
+		WARN("vuh is built without glslang, skipping compilation");
+		return;
+	}
+	REQUIRE_THROWS_AS(vuh::compile_glsl(source), vuh::CompilationFailure); // undefined names
+
+	const auto code = vuh::compile_glsl(source, defines, ".");
+	{
+		auto fin = std::ifstream(path, std::ios::binary);
+		const auto cached = std::vector<char>(std::istreambuf_iterator<char>(fin)
+		                                      , std::istreambuf_iterator<char>());
+		REQUIRE(cached == code); // stored to cache
+	}
+	REQUIRE(vuh::compile_glsl(source, defines, ".") == code); // taken from cache
+
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	auto y = std::vector<float>(size, 1.0f);
+	auto d_y = vuh::Array<float>(device, y);
+	auto d_x = vuh::Array<float>(device, std::vector<float>(size, 2.0f));
+	auto program = vuh::Program<>(device, code);
+	program.grid_for(size, wg)(d_y, d_x);
+	d_y.toHost(begin(y));
+
+	REQUIRE(y == approx(std::vector<float>(size, 2.0f)).eps(1.e-5));
+}
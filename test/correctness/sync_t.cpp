@@ -0,0 +1,145 @@
+#include <catch2/catch.hpp>
+#include "approx.hpp"
+#include "saxpy_fixture.hpp"
+
+#include <vuh/vuh.h>
+#include <vuh/array.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+using test::approx;
+
+TEST_CASE_METHOD(test::Saxpy<>, "sync operations wait on their own fences", "[program][correctness]"){
+	auto program = make_program();
+
+	SECTION("blocking wait"){
+		const auto before = device.poolStats().fences;
+		program({size, a}, d_y, d_x);
+		const auto after = device.poolStats().fences;
+		REQUIRE(after.hits + after.misses == before.hits + before.misses + 1);
+		REQUIRE(after.size == std::max<std::size_t>(before.size, 1));
+	}
+	SECTION("spin then block, device setting"){
+		device.syncSpin(std::chrono::microseconds(50));
+		program({size, a}, d_y, d_x);
+	}
+	SECTION("spin then block, program setting"){
+		program.spin_wait(std::chrono::microseconds(50));
+		program({size, a}, d_y, d_x);
+	}
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(expected(1)).eps(1.e-5));
+}
+
+TEST_CASE_METHOD(test::Saxpy<1024>, "async operations reuse fences and command buffers", "[correctness][async]"){
+	constexpr auto n_runs = 8u;
+	auto program = make_program();
+	program.run_async({size, a}, d_y, d_x).wait(); // warm up
+	program({size, a}, d_y, d_x);
+
+	const auto timeline = device.features().timeline_semaphore;
+	const auto before = device.poolStats();
+	for(uint32_t i = 0; i < n_runs; ++i){
+		program.run_async({size, a}, d_y, d_x).wait();
+	}
+	const auto after = device.poolStats();
+	if(timeline){ // async runs are tracked with no fences
+		REQUIRE(after.fences.hits == before.fences.hits);
+	} else {
+		REQUIRE(after.fences.hits - before.fences.hits == n_runs);
+		REQUIRE(after.fences.hitRate() > before.fences.hitRate());
+	}
+	REQUIRE(after.fences.misses == before.fences.misses);
+	REQUIRE(after.fences.size == before.fences.size);
+	REQUIRE(after.compute_buffers.hits - before.compute_buffers.hits == n_runs);
+	REQUIRE(after.compute_buffers.misses == before.compute_buffers.misses);
+	REQUIRE(after.compute_buffers.size == before.compute_buffers.size);
+
+	for(uint32_t i = 0; i < n_runs; ++i){ // sync runs take the pool fences on any device
+		program({size, a}, d_y, d_x);
+	}
+	const auto after_sync = device.poolStats();
+	REQUIRE(after_sync.fences.hits - after.fences.hits == n_runs);
+	REQUIRE(after_sync.fences.misses == after.fences.misses);
+	REQUIRE(after_sync.fences.size == after.fences.size);
+
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(expected(2*n_runs + 2)).eps(1.e-5));
+}
+
+TEST_CASE_METHOD(test::Saxpy<1024>, "async runs take consecutive timeline points", "[correctness][async]"){
+	if(!device.features().timeline_semaphore){
+		WARN("device does not support timeline semaphores, skipping");
+		return;
+	}
+	auto program = make_program();
+	auto last = vuh::TimelinePoint{};
+	for(int i = 0; i < 4; ++i){
+		auto token = program.run_async({size, a}, d_y, d_x);
+		REQUIRE(token.point().semaphore);
+		if(last.semaphore){ // same compute queue timeline
+			REQUIRE(token.point().semaphore == last.semaphore);
+			REQUIRE(token.point().value == last.value + 1);
+		}
+		last = token.point();
+		token.wait();
+	}
+}
+
+TEST_CASE_METHOD(test::Saxpy<1024>, "async operations chained on the device", "[correctness][async]"){
+	auto y = std::vector<float>(size, 1.0f);
+	auto program = make_program();
+	{
+		auto t_copy = vuh::copy_async(begin(y), end(y), device_begin(d_y));
+		auto t_1 = program.after(t_copy).run_async({size, a}, d_y, d_x);
+		REQUIRE(bool(t_1.point().semaphore) == device.features().timeline_semaphore);
+		auto t_2 = program.after(t_1).run_async({size, a}, d_y, d_x);
+		program.after(t_2)({size, a}, d_y, d_x); // sync run waiting for the async chain
+	} // tokens are waited for here
+
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(expected(3)).eps(1.e-5));
+}
+
+TEST_CASE("upload chained to the kernel with queue family ownership transfer", "[correctness][async]"){
+	constexpr auto arr_size = 1024u;
+	const auto a = 0.5f;
+	auto instance = vuh::Instance();
+	auto device = instance.devices().at(0);
+	REQUIRE(device.queueSharing() == vuh::QueueSharing::Concurrent);
+	auto sharing = vuh::QueueSharing::Concurrent;
+	SECTION("exclusive sharing"){ sharing = vuh::QueueSharing::Exclusive; }
+	SECTION("concurrent sharing"){ sharing = vuh::QueueSharing::Concurrent; }
+	device.queueSharing(sharing); // before the arrays are created
+	const auto transfers = sharing == vuh::QueueSharing::Exclusive && device.hasSeparateQueues();
+
+	auto y = std::vector<float>(arr_size, 1.0f);
+	auto d_y = vuh::Array<float>(device, arr_size);
+	auto d_x = vuh::Array<float>(device, std::vector<float>(arr_size, 2.0f));
+	using Specs = vuh::typelist<uint32_t>;
+	struct Params{uint32_t size; float a;};
+	auto program = vuh::Program<Specs, Params>(device, "../shaders/saxpy.spv");
+	program.grid(arr_size/64).spec(64);
+	{
+		auto t_copy = vuh::copy_async(begin(y), end(y), device_begin(d_y));
+		const auto acquire = t_copy.pending_acquire();
+		REQUIRE(bool(acquire.buffer) == transfers);
+		if(transfers){
+			REQUIRE(acquire.buffer == vk::Buffer(d_y));
+			REQUIRE(acquire.srcQueueFamilyIndex == device.transferFamilyId());
+			REQUIRE(acquire.dstQueueFamilyIndex == device.computeFamilyId());
+		}
+		auto t_comp = program.after(t_copy).run_async({arr_size, a}, d_y, d_x);
+		REQUIRE(!t_copy.pending_acquire().buffer); // handed over to the program
+	}
+	REQUIRE(d_y.toHost<std::vector<float>>() == approx(std::vector<float>(arr_size, 1.0f + a*2.0f)).eps(1.e-5));
+
+	if(transfers){ // transfer the ownership after the bind
+		auto t_copy = vuh::copy_async(begin(y), end(y), device_begin(d_y));
+		program.bind({arr_size, a}, d_y, d_x);
+		REQUIRE_THROWS_AS(program.after(t_copy).run(), std::logic_error);
+	} else {
+		WARN("compute and transfer queues share the family, ownership transfer is not exercised");
+	}
+}
@@ -0,0 +1,133 @@
+#include <sltbench/Bench.h>
+
+#include <vuh/array.hpp>
+#include <vuh/vuh.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <vector>
+
+namespace {
+	std::atomic<std::size_t> n_allocations{0}; ///< heap allocations made by the process so far
+} // namespace
+
+/// Count the heap allocations. Array and sized forms end up here by default.
+auto operator new(std::size_t size)-> void* {
+	n_allocations.fetch_add(1, std::memory_order_relaxed);
+	if(auto p = std::malloc(size > 0 ? size : 1)){
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+auto operator delete(void* p) noexcept-> void {
+	std::free(p);
+}
+
+namespace {
+	/// Push-parameters to the saxpy kernel + some aux functions
+	struct Params{
+		uint32_t size; ///< size of a vector
+		float a;       ///< saxpy scaling parameter
+
+		auto operator== (const Params& other) const-> bool {return size == other.size && a == other.a;}
+		auto operator!= (const Params& other) const-> bool {return !(*this == other);}
+
+		friend auto operator<< (std::ostream& s, const Params& p)-> std::ostream& {
+			return s << "{" << p.size << ", " << p.a << "}";
+		}
+	};
+
+	using Program = vuh::Program<vuh::typelist<uint32_t>, Params>;
+
+	auto instance = vuh::Instance();
+	vuh::Device device = instance.devices().at(0); ///< gpu device
+
+	/// Kernel with its arguments, dispatched over and over.
+	struct Dispatch {
+		static constexpr auto workgroup_size = 128u;
+
+		Params p = {0, 0.f};
+		Program program = Program(device, "../shaders/saxpy.spv");
+		std::unique_ptr<vuh::Array<float>> d_y;
+		std::unique_ptr<vuh::Array<float>> d_x;
+
+		/// Bind and run, wait for completion.
+		auto sync()-> void { program(p, *d_y, *d_x); }
+
+		/// Bind and run async, wait for completion.
+		auto async()-> void { program.run_async(p, *d_y, *d_x).wait(); }
+
+		/// Async copy between device arrays, wait for completion.
+		auto copy()-> void { vuh::copy_async(device_begin(*d_x), device_end(*d_x), device_begin(*d_y)).wait(); }
+	};
+
+	/// Fixture copying data to device-local memory and setting up the kernel.
+	/// The first dispatches warm up the objects recycled in the steady state.
+	struct FixDispatch {
+		using Type = Dispatch;
+
+		auto SetUp(const Params& p)-> Type& {
+			if(p != d.p){
+				d.p = p;
+				d.d_y = std::make_unique<vuh::Array<float>>(device, std::vector<float>(p.size, 3.14f));
+				d.d_x = std::make_unique<vuh::Array<float>>(device, std::vector<float>(p.size, 6.28f));
+				d.program.grid_for(p.size, Dispatch::workgroup_size).spec(Dispatch::workgroup_size);
+				d.sync();
+				d.async();
+				d.copy();
+			}
+			return d;
+		}
+
+		auto TearDown()-> void {}
+	private:
+		Dispatch d;
+	}; // struct FixDispatch
+
+	/// Benchmarked function. Bind and run synchronously.
+	auto dispatch_sync(Dispatch& d, const Params& /*p*/)-> void { d.sync(); }
+
+	/// Benchmarked function. Bind, run async and wait.
+	auto dispatch_async(Dispatch& d, const Params& /*p*/)-> void { d.async(); }
+
+	/// Benchmarked function. Copy between device arrays async and wait.
+	auto copy_device_async(Dispatch& d, const Params& /*p*/)-> void { d.copy(); }
+
+	/// @return average number of heap allocations per call of the function, after the warm-up
+	template<class F>
+	auto allocations_per_call(F&& f)-> double {
+		constexpr auto n_warmup = 4;
+		constexpr auto n_calls = 256;
+		for(int i = 0; i < n_warmup; ++i){
+			f();
+		}
+		const auto start = n_allocations.load();
+		for(int i = 0; i < n_calls; ++i){
+			f();
+		}
+		return double(n_allocations.load() - start)/n_calls;
+	}
+
+	/// Set of parameters to run benchmakrs on.
+	static const auto params = std::vector<Params>({{1u << 10, 2.f}, {1u << 16, 3.f}});
+} // namespace
+
+SLTBENCH_FUNCTION_WITH_FIXTURE_AND_ARGS(dispatch_sync, FixDispatch, params)
+SLTBENCH_FUNCTION_WITH_FIXTURE_AND_ARGS(dispatch_async, FixDispatch, params)
+SLTBENCH_FUNCTION_WITH_FIXTURE_AND_ARGS(copy_device_async, FixDispatch, params)
+
+/// Report the heap allocations per dispatch (and per async copy) in the steady state,
+/// then run the timing benchmarks.
+int main(int argc, char** argv) {
+	auto fixture = FixDispatch{};
+	auto& d = fixture.SetUp(params.front());
+	std::cout << "allocations per dispatch, sync: " << allocations_per_call([&]{ d.sync(); })
+	          << ", async: " << allocations_per_call([&]{ d.async(); })
+	          << "; per device copy_async: " << allocations_per_call([&]{ d.copy(); }) << std::endl;
+	return sltbench::Main(argc, argv);
+}
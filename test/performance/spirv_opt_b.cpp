@@ -0,0 +1,76 @@
+#include <sltbench/Bench.h>
+
+#include <vuh/array.hpp>
+#include <vuh/vuh.h>
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace {
+	/// Push-parameters to the saxpy kernel + some aux functions
+	struct Params{
+		uint32_t size; ///< size of a vector
+		float a;       ///< saxpy scaling parameter
+
+		auto operator== (const Params& other) const-> bool {return size == other.size && a == other.a;}
+		auto operator!= (const Params& other) const-> bool {return !(*this == other);}
+
+		friend auto operator<< (std::ostream& s, const Params& p)-> std::ostream& {
+			return s << "{" << p.size << ", " << p.a << "}";
+		}
+	};
+
+	using Program = vuh::Program<vuh::typelist<uint32_t>, Params>;
+
+	auto instance = vuh::Instance();
+	vuh::Device device = instance.devices().at(0); ///< gpu device
+
+	/// Fixture copying data to device-local memory and binding all parameters to the kernel
+	/// which code is optimized with a given recipe.
+	template<vuh::SpirvOpt Recipe, bool Freeze>
+	struct FixOptimized {
+		using Type = Program;
+		static constexpr auto workgroup_size = 128u;
+
+		FixOptimized(){ program.optimize(Recipe, Freeze); }
+
+		auto SetUp(const Params& p)-> Type& {
+			if(p != this->p){
+				this->p = p;
+				d_y = std::make_unique<vuh::Array<float>>(device, std::vector<float>(p.size, 3.14f));
+				d_x = std::make_unique<vuh::Array<float>>(device, std::vector<float>(p.size, 6.28f));
+				program.grid_for(p.size, workgroup_size)
+				       .spec(workgroup_size)
+				       .bind(p, *d_y, *d_x);
+			}
+			return program;
+		}
+
+		auto TearDown()-> void {}
+
+	private:
+		Params p = {0, 0.f};
+		Program program = Program(device, "../shaders/saxpy.spv");
+		std::unique_ptr<vuh::Array<float>> d_y;
+		std::unique_ptr<vuh::Array<float>> d_x;
+	}; // struct FixOptimized
+
+	using FixPlain = FixOptimized<vuh::SpirvOpt::None, false>;
+	using FixPerformance = FixOptimized<vuh::SpirvOpt::Performance, false>;
+	using FixPerformanceFrozen = FixOptimized<vuh::SpirvOpt::Performance, true>;
+
+	/// Benchmarked function. Just run the kernel, assumes the data copied and kernel all set up.
+	auto saxpy(Program& program, const Params& /*p*/)-> void {
+		program.run();
+	}
+
+	/// Set of parameters to run benchmakrs on.
+	static const auto params = std::vector<Params>({{1u << 12, 2.f}, {1u << 16, 2.f}, {1u << 20, 3.f}});
+} // namespace
+
+SLTBENCH_FUNCTION_WITH_FIXTURE_AND_ARGS(saxpy, FixPlain, params)
+SLTBENCH_FUNCTION_WITH_FIXTURE_AND_ARGS(saxpy, FixPerformance, params)
+SLTBENCH_FUNCTION_WITH_FIXTURE_AND_ARGS(saxpy, FixPerformanceFrozen, params)
+
+SLTBENCH_MAIN()